@@ -0,0 +1,38 @@
+#ifndef BATCHEVAL_H
+#define BATCHEVAL_H
+
+#include "Board.h"
+#include "PackedPosition.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// positions handled per SIMD step, batches are padded to a multiple of this
+#define BATCH_LANES 8
+
+// many positions stored square by square (structure of arrays), so the
+// evaluator reads the same square of consecutive positions from one
+// contiguous run of bytes. A square holds 0 when empty, otherwise
+// 1 + colorIndex() * 6 + PieceType.
+class PositionBatch {
+private:
+    std::vector<uint8_t> squares[64];
+    size_t count = 0;
+public:
+    void add(const Board& board);
+    // straight from a dataset record, no Board needed
+    void add(const PackedPosition& packed);
+    void clear();
+    size_t size() const;
+    uint8_t pieceCode(size_t position, int square) const;
+    // material + piece-square score of every position, tapered by game
+    // phase, from white's point of view. Matches taper(board.psqScore,
+    // board.gamePhase) exactly; the AVX2 build scores eight positions at once.
+    void evaluate(std::vector<int>& scores) const;
+    // one position at a time, kept as the reference for evaluate()
+    void evaluateScalar(std::vector<int>& scores) const;
+    // instruction set evaluate() was compiled for
+    static const char* simdName();
+};
+
+#endif
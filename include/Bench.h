@@ -0,0 +1,44 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "SearchStats.h"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// plies searched per position by default, about 15 seconds in all on one core
+#define BENCH_DEPTH 4
+
+struct BenchPosition {
+    std::string fen;
+    uint64_t nodes = 0;
+    // milliseconds
+    int64_t time = 0;
+    // in coordinates, "0000" without a legal move
+    std::string bestMove;
+};
+
+struct BenchReport {
+    int depth = 0;
+    // the sum over all positions; it only changes when the search does, so
+    // it tells a pure speed-up from a change in behaviour
+    uint64_t nodes = 0;
+    int64_t time = 0;
+    std::vector<BenchPosition> positions;
+    // summed over all positions, empty unless built with SEARCH_STATS
+    SearchStats stats;
+
+    uint64_t nodesPerSecond() const;
+};
+
+// searches each of the fixed bench positions to depth on a single thread
+// with a freshly cleared cache, so the node count is the same on every
+// run and machine; progress, if given, gets a line per position
+BenchReport runBench(int depth = BENCH_DEPTH, std::ostream* progress = nullptr);
+// the totals as text, or the whole report as one JSON object
+void printBench(const BenchReport& report, std::ostream& out, bool json);
+// "bench [depth] [json]" from a command line or a front end's input
+bool parseBenchArguments(const std::vector<std::string>& arguments, int& depth, bool& json);
+
+#endif
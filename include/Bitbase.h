@@ -0,0 +1,31 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "Board.h"
+#include <cstdint>
+#include <string>
+
+// Win/draw tables for the three piece endings KPK, KRK and KQK, written by
+// the BitbaseGen tool. Positions are stored with the strong side as white,
+// its pawn moving towards row 0; black-strong positions are probed with the
+// rows flipped. One bit per position, set when the strong side wins.
+//
+// File layout: char magic[4] = "BFBB", uint32 version = 1, then
+// BITBASE_POSITIONS bits, little-endian bit order within each byte.
+#define BITBASE_POSITIONS (2 * 64 * 64 * 64)
+#define BITBASE_HEADER_SIZE 8
+
+// strongToMove is 1 when the side with the extra piece is to move
+constexpr int bitbaseIndex(int strongToMove, int strongKing, int weakKing, int piece) {
+    return ((strongToMove * 64 + strongKing) * 64 + weakKing) * 64 + piece;
+}
+
+enum BitbaseResult { BITBASE_UNKNOWN, BITBASE_DRAW, BITBASE_WIN };
+
+// maps kpk.bb, krk.bb and kqk.bb from a directory, returns how many were found
+int loadBitbases(const std::string& directory);
+// exact result of a three piece ending if its bitbase is loaded; strongSide
+// is set to the colorIndex() of the side with the extra piece
+BitbaseResult probeBitbase(const Board& board, int sideToMove, int& strongSide);
+
+#endif
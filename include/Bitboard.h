@@ -0,0 +1,139 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// one bit per square, bit (row * 8 + col) using the same row/col as Board::board
+typedef uint64_t Bitboard;
+
+inline Bitboard squareBit(int row, int col) {
+    return 1ULL << (row * 8 + col);
+}
+
+inline int popcount(Bitboard b) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(b);
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// index of the lowest set bit, b must not be empty
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return (int)index;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// index of the highest set bit, b must not be empty
+inline int msb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, b);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(b);
+#endif
+}
+
+// removes and returns the lowest set bit
+inline int popLsb(Bitboard& b) {
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+const Bitboard fileABitboard = 0x0101010101010101ULL;
+
+// rays run in 8 directions, the first four towards higher square indices
+// and the last four towards lower ones
+enum Direction { SOUTH, EAST, SOUTH_EAST, SOUTH_WEST, NORTH, WEST, NORTH_WEST, NORTH_EAST };
+
+// squares a piece attacks from each square on an empty board
+struct AttackTables {
+    Bitboard knight[64];
+    Bitboard king[64];
+    // pawn captures, indexed by colorIndex()
+    Bitboard pawn[2][64];
+    Bitboard rays[8][64];
+};
+
+constexpr AttackTables buildAttackTables() {
+    const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+    const int kingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    const int directions[8][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}, {-1, 0}, {0, -1}, {-1, -1}, {-1, 1}};
+    AttackTables tables{};
+    for (int square = 0; square < 64; square++) {
+        int row = square / 8;
+        int col = square % 8;
+        for (int k = 0; k < 8; k++) {
+            int r = row + knightSteps[k][0];
+            int c = col + knightSteps[k][1];
+            if (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                tables.knight[square] |= 1ULL << (r * 8 + c);
+            }
+            r = row + kingSteps[k][0];
+            c = col + kingSteps[k][1];
+            if (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                tables.king[square] |= 1ULL << (r * 8 + c);
+            }
+        }
+        // white pawns move towards row 0, black pawns towards row 7
+        for (int dc = -1; dc <= 1; dc += 2) {
+            if (col + dc >= 0 && col + dc < 8) {
+                if (row > 0) {
+                    tables.pawn[0][square] |= 1ULL << ((row - 1) * 8 + col + dc);
+                }
+                if (row < 7) {
+                    tables.pawn[1][square] |= 1ULL << ((row + 1) * 8 + col + dc);
+                }
+            }
+        }
+        for (int dir = 0; dir < 8; dir++) {
+            int r = row + directions[dir][0];
+            int c = col + directions[dir][1];
+            while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                tables.rays[dir][square] |= 1ULL << (r * 8 + c);
+                r += directions[dir][0];
+                c += directions[dir][1];
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr AttackTables attackTables = buildAttackTables();
+
+// ray from a square up to and including the first occupied square
+inline Bitboard rayAttacks(int dir, int square, Bitboard occupied) {
+    Bitboard ray = attackTables.rays[dir][square];
+    Bitboard blockers = ray & occupied;
+    if (blockers) {
+        int blocker = (dir < NORTH) ? lsb(blockers) : msb(blockers);
+        ray ^= attackTables.rays[dir][blocker];
+    }
+    return ray;
+}
+
+inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+    return rayAttacks(SOUTH_EAST, square, occupied) | rayAttacks(SOUTH_WEST, square, occupied)
+        | rayAttacks(NORTH_WEST, square, occupied) | rayAttacks(NORTH_EAST, square, occupied);
+}
+
+inline Bitboard rookAttacks(int square, Bitboard occupied) {
+    return rayAttacks(SOUTH, square, occupied) | rayAttacks(EAST, square, occupied)
+        | rayAttacks(NORTH, square, occupied) | rayAttacks(WEST, square, occupied);
+}
+
+inline Bitboard queenAttacks(int square, Bitboard occupied) {
+    return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+#endif
@@ -2,10 +2,20 @@
 #define BOARD_H
 
 #include "Piece.h"
+#include "Bitboard.h"
+#include "Zobrist.h"
+#include "Nnue.h"
+#include "Material.h"
+#include "Score.h"
+#include <string>
+#include <string_view>
 #include <vector>
 #include <tuple>
 using namespace std;
 
+struct PositionFields;
+struct PackedPosition;
+
 struct castle {
     bool kingSide;
     bool queenSide;
@@ -16,10 +26,15 @@ protected:
     bool isBlackInCheck = false;
     bool isWhiteInCheck = false;
     bool isWithinBoard(int startX, int startY, int endX, int endY);
-    char currentPlayer;
+    void copyFrom(const Board& other);
+    char currentPlayer = 'W';
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
     pair<int, int> enPassantTarget;
     castle whiteCastlingRights;
     castle blackCastlingRights;
+    // shared by the FEN and packed loaders, after validation
+    void setPosition(const PositionFields& fields);
 public:
     Board();
     ~Board();
@@ -31,14 +46,58 @@ public:
     Piece* getPieceAt(int row, int col) const;
     char getPieceColor(int row, int col) const;  
     void initialise();
-    void loadFromFEN(string fen);
+    // replaces the whole position; false, leaving the board untouched, when
+    // the FEN is malformed or not a legal position. EPD style strings
+    // without the move counters are accepted.
+    bool loadFromFEN(std::string_view fen);
+    // the same from a record of a packed dataset, see PackedPosition.h
+    bool loadPacked(const PackedPosition& packed);
+    std::string toFEN() const;
+    char getSideToMove() const;
+    // file of the en passant target after a double pawn push, -1 for none
+    int getEnPassantFile() const;
+    int getHalfmoveClock() const;
+    int getFullmoveNumber() const;
     void display() const;
-    bool movePiece(int startX, int startY, int endX, int endY, char currentPlayer);
+    // promotion is the PieceType a pawn reaching the last rank becomes
+    bool movePiece(int startX, int startY, int endX, int endY, char currentPlayer, int promotion=QUEEN);
     std::vector<std::pair<int, int>> getLegalMoves(int startX, int startY, char currentPlayer);
     bool isLegalMove(int startX, int startY, int endX, int endY, bool flag=false);
     std::tuple<int, int> getBlackKing();
     std::tuple<int, int> getWhiteKing();
     tuple<int, int, int, int> previousMove = {-1, -1, -1, -1};
     long long perft(int depth, char currentPlayer, long long& captureCount);
+    // king and rook are still unmoved on their home squares, squares in
+    // between and checks are not looked at
+    bool hasCastlingRight(char color, bool kingSide) const;
+    // whether the king of color is attacked, from the bitboards
+    bool inCheck(char color) const;
+
+    // running material + piece-square total (white minus black) and game
+    // phase, kept in sync by putPiece/takePiece so evaluation does not
+    // rescan the board
+    Score psqScore = 0;
+    int gamePhase = 0;
+    // occupancy by colour and piece type, indexed by colorIndex() and PieceType
+    Bitboard pieceBitboards[2][6] = {};
+    Bitboard colorBitboards[2] = {};
+    // Zobrist key of the pawns only, used by the pawn hash table
+    uint64_t pawnKey = zobrist.noPawns;
+    // Zobrist key of all pieces, side to move and castling are not included
+    uint64_t hashKey = 0;
+    // piece counts of both sides, see Material.h
+    MaterialKey materialKey = 0;
+    // first layer of the NNUE evaluator, only maintained once weights are loaded
+    alignas(32) int16_t accumulator[NNUE_HIDDEN];
+    void refreshAccumulator();
+    void putPiece(int row, int col, Piece* piece);
+    Piece* takePiece(int row, int col);
+    void computeScores(Score& psq, int& phase) const;
+    // packed material + piece-square score of one piece, white's point of view
+    static Score pieceSquareScore(int color, int type, int square);
+    // rebuild everything putPiece/takePiece maintain from the board
+    void refreshState();
+    // compare the incremental state against a full recomputation
+    bool verifyState() const;
 };
 #endif
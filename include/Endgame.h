@@ -0,0 +1,29 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "Board.h"
+#include "Material.h"
+
+// base score of a won endgame; the evaluators add bonuses that drive the
+// position towards mate, staying well below the search's mate score
+#define KNOWN_WIN 10000
+
+// scores a position from white's point of view, strongSide is the
+// colorIndex() of the side with the extra material
+typedef int (*EndgameFunction)(const Board& board, int strongSide);
+
+struct EndgameEntry {
+    MaterialKey key;
+    EndgameFunction function;
+    int strongSide;
+};
+
+// the specialized evaluator for the board's material, or nullptr
+const EndgameEntry* probeEndgame(const Board& board);
+// score of a position the strong side is known to win, e.g. from a bitbase,
+// with bonuses for promoting the pawn or driving the lone king to the edge
+int knownWinScore(const Board& board, int strongSide);
+// neither side can ever mate, whatever the position (KK, KNK, KBK)
+bool isDeadDraw(MaterialKey key);
+
+#endif
@@ -2,25 +2,125 @@
 #define ENGINE_H
 
 #include <Board.h>
-#include <unordered_map>
+#include "EvalCache.h"
+#include "PawnHash.h"
+#include "Polyglot.h"
+#include "SearchStats.h"
+#include "SearchTree.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#define MAX_SEARCH_DEPTH 64
+// a side mated ply plies from the root scores -(MATE_SCORE - ply) from its
+// own point of view, so nearer mates count for more; any score at least
+// MATE_BOUND away from zero is a mate
+#define MATE_SCORE 1000000
+#define MATE_BOUND (MATE_SCORE - MAX_SEARCH_DEPTH)
+// evaluation holds the terms after material, piece-square and pawn
+// structure to this many centipawns either way, so when those alone are
+// this far outside the window the rest can be skipped
+#define LAZY_EVAL_MARGIN 1000
+
+// limits for Engine::search(), zero means no limit; times are in milliseconds
+struct SearchLimits {
+    // in plies
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t moveTime = 0;
+    // remaining clock and increment, indexed by colorIndex()
+    int64_t time[2] = {0, 0};
+    int64_t increment[2] = {0, 0};
+    int movesToGo = 0;
+    bool infinite = false;
+    // the clock only starts once ponderHit() is called
+    bool ponder = false;
+};
+
+// state after a completed iteration of Engine::search()
+struct SearchInfo {
+    int depth = 0;
+    // white's point of view, like evaluate()
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t time = 0;
+    // from.first is -1 when there is no legal move
+    std::pair<std::pair<int, int>, std::pair<int, int>> bestMove = {{-1, -1}, {-1, -1}};
+    // likely reply to bestMove, from a one ply search; from.first is -1 when unknown
+    std::pair<std::pair<int, int>, std::pair<int, int>> ponderMove = {{-1, -1}, {-1, -1}};
+};
 
 class Engine {
 private:
-    unordered_map<std::string, int> pieceValues = {{"Pawn", 100}, 
-                                                    {"Knight", 300}, 
-                                                    {"Bishop", 300},
-                                                    {"Rook", 500},
-                                                    {"Queen", 900},
-                                                    {"King", 0}};
     char color;
     Board& board;
+    // filled by evaluate(), which is logically const
+    mutable EvalCache evalCache;
+    bool useNnue = false;
+    const PolyglotBook* book = nullptr;
+    bool bookBestOnly = false;
+    int threadCount;
+    // pawn structure caches, one per search thread, kept between iterations and moves
+    std::vector<PawnHashTable> pawnTables;
+    // set by stop() or when a limit is reached, searches unwind as soon as they see it
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> pondering{false};
+    std::atomic<uint64_t> searchNodes{0};
+    // steady clock milliseconds; the time limit counts from clockStart,
+    // which ponderHit() restarts
+    int64_t searchStart = 0;
+    std::atomic<int64_t> clockStart{0};
+    int64_t timeLimit = 0;
+    uint64_t nodeLimit = 0;
+    // totals of the last search, see SearchStats.h
+    SearchStats searchStats;
+    // gets every minimax node while attached
+    SearchTreeRecorder* treeRecorder = nullptr;
+    int staticEvaluation(Board& threadLocalBoard, int alpha, int beta, bool& exact) const;
+    // a legal move from the opening book, if there is one
+    bool probeBook(char currentPlayer, std::pair<std::pair<int, int>, std::pair<int, int>>& move);
+    // searches every root move to depth plies, at least 1, counting the root
+    // move, on threadCount threads; false when there is no legal move
+    bool searchRoot(Board& rootBoard, char currentPlayer, int depth,
+                    std::pair<std::pair<int, int>, std::pair<int, int>>& bestMove, int& bestValue);
+    // plies of the searchRoot() in progress, for the distance of mates
+    int rootDepth = 0;
+    // mate or stalemate score of a node without legal moves, depth plies above the leaves
+    int noMoveScore(const Board& threadLocalBoard, char currentPlayer, int depth) const;
+    // minimax itself; record, when not null, is filled in with how the node ended
+    int searchNode(int depth, char currentPlayer, int alpha, int beta, Board& threadLocalBoard, SearchTreeNode* record);
+    int64_t elapsed() const;
+    void checkLimits();
 public:
     Engine(Board& board, char color);
     std::pair<std::pair<int, int>, std::pair<int, int>> getBestMove(char currentPlayer);
-    int evaluate(Board& threadLocalBoard) const;
-    bool moveAndUnmove(int startX, int startY, int endX, int endY, int &eval, int depth, char currentPlayer, Board& threadLocalBoard, bool flag=false);
-    int evaluatePosition(int depth, char currentPlayer, Board& threadLocalBoard);
+    // iterative deepening within the limits, or a book move at depth 0;
+    // onIteration is called from the searching thread after every completed depth
+    SearchInfo search(char currentPlayer, const SearchLimits& limits,
+                      const std::function<void(const SearchInfo&)>& onIteration = nullptr);
+    // both may be called from any thread while search() runs
+    void stop();
+    void ponderHit();
+    // scores outside the alpha-beta window may be returned as a bound that
+    // is still outside it, without computing the expensive terms
+    int evaluate(Board& threadLocalBoard, int alpha=-1000000, int beta=1000000) const;
+    // depth counts the move itself and is at least 1: the position after it
+    // is searched depth - 1 plies deep
+    bool moveAndUnmove(int startX, int startY, int endX, int endY, int &eval, int depth, char currentPlayer, Board& threadLocalBoard, bool flag=false, int alpha=-1000000, int beta=1000000);
+    int evaluatePosition(int depth, char currentPlayer, Board& threadLocalBoard, int alpha=-1000000, int beta=1000000);
     int minimax(int depth, char currentPlayer, int alpha, int beta, Board& threadLocalBoard);
+    // counters of the last search(), all zero unless built with SEARCH_STATS
+    const SearchStats& getSearchStats() const;
+    // switch between the classic and the NNUE evaluator, fails if no network is loaded
+    bool setUseNnue(bool enable);
+    // play from an opening book while it has moves, nullptr to switch it off
+    void setBook(const PolyglotBook* openingBook, bool bestOnly=false);
+    // record the search trees into recorder, nullptr to stop; not while searching
+    void setTreeRecorder(SearchTreeRecorder* recorder);
+    void setThreads(int count);
+    // resizes and clears the evaluation cache, not while searching
+    void setHashSize(size_t megabytes);
+    void clearHash();
 };
 
 #endif
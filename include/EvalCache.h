@@ -0,0 +1,30 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// default number of entries in the evaluation cache, must be a power of two
+#define EVAL_CACHE_SIZE (1 << 20)
+
+// fixed-size cache of static evaluations keyed by Board::hashKey, shared by
+// all search threads without locking. Each entry is one 64-bit word holding
+// the upper half of the key and the score, so a torn read is impossible and
+// a probe costs a single memory access.
+class EvalCache {
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> entries;
+    size_t mask;
+public:
+    EvalCache(size_t size = EVAL_CACHE_SIZE);
+    bool probe(uint64_t key, int& score) const;
+    void store(uint64_t key, int score);
+    void clear();
+    // size must be a power of two, the cache is emptied
+    void resize(size_t size);
+    size_t size() const;
+};
+
+#endif
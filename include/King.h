@@ -32,9 +32,12 @@ public:
 
     std::string getType() const override;
 
+    PieceType getPieceType() const override;
+
     bool isValidPieceMove(int startX, int startY, int endX, int endY, const std::vector<std::vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const override;
 
     void makeMove() override;
+    void setMoved(bool moved) override;
 
     bool checkPseudoCastle(int endX, int endY, const std::vector<std::vector<Piece*>>& board) const;
 
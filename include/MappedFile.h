@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// read-only view of a whole file mapped into memory. The operating system
+// loads pages on first access, so opening a large file is cheap and
+// untouched parts never take up memory.
+class MappedFile {
+private:
+    const uint8_t* mapping = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    // maps the file, replacing any previous mapping; empty files fail
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    const uint8_t* data() const;
+    size_t size() const;
+};
+
+#endif
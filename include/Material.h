@@ -0,0 +1,45 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <cstdint>
+
+// material signature of a position: the number of pawns, knights, bishops,
+// rooks and queens of each side, 4 bits per count, white in the low 20 bits.
+// Kings are always there and not counted. Unlike a Zobrist key it is exact,
+// so two positions share a key only if they have the same material.
+typedef uint64_t MaterialKey;
+
+// key difference made by one piece, indexed by colorIndex() and PieceType
+constexpr MaterialKey materialKeyUnit(int color, int type) {
+    return type >= 5 ? 0 : 1ULL << (4 * (color * 5 + type));
+}
+
+// number of pieces of one colour and type in a key
+constexpr int materialCount(MaterialKey key, int color, int type) {
+    return (int)((key >> (4 * (color * 5 + type))) & 0xF);
+}
+
+// key of a signature written like "KRK" or "KBNK": white's pieces after
+// the first K, black's after the second
+constexpr MaterialKey materialKeyOf(const char* code) {
+    MaterialKey key = 0;
+    int color = -1;
+    for (const char* c = code; *c; c++) {
+        switch (*c) {
+            case 'K': color++; break;
+            case 'P': key += materialKeyUnit(color, 0); break;
+            case 'N': key += materialKeyUnit(color, 1); break;
+            case 'B': key += materialKeyUnit(color, 2); break;
+            case 'R': key += materialKeyUnit(color, 3); break;
+            case 'Q': key += materialKeyUnit(color, 4); break;
+        }
+    }
+    return key;
+}
+
+// the same material with the colours swapped
+constexpr MaterialKey mirrorMaterialKey(MaterialKey key) {
+    return ((key & 0xFFFFF) << 20) | (key >> 20);
+}
+
+#endif
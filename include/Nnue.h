@@ -0,0 +1,46 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+
+// network shape: one input per (colour, piece type, square), a hidden layer
+// kept incrementally in Board, then two small dense layers and the output
+#define NNUE_INPUTS 768
+#define NNUE_HIDDEN 256
+#define NNUE_L2 32
+#define NNUE_L3 32
+
+// dense layer outputs are shifted right by this before clipping to 0..127
+#define NNUE_SHIFT 6
+// the network output divided by this is the score in centipawns
+#define NNUE_OUTPUT_DIVISOR 16
+
+// input feature of a piece, colour from colorIndex() and type from PieceType
+inline int nnueFeature(int color, int type, int square) {
+    return (color * 6 + type) * 64 + square;
+}
+
+// quantized evaluation network. Weights are loaded from a little-endian
+// binary file laid out as:
+//   char magic[4] = "BFNN", uint32 version = 1, uint32 hidden = NNUE_HIDDEN
+//   int16 hiddenBias[NNUE_HIDDEN], int16 hiddenWeights[NNUE_INPUTS][NNUE_HIDDEN]
+//   int32 l2Bias[NNUE_L2], int8 l2Weights[NNUE_L2][NNUE_HIDDEN]
+//   int32 l3Bias[NNUE_L3], int8 l3Weights[NNUE_L3][NNUE_L2]
+//   int32 outputBias, int8 outputWeights[NNUE_L3]
+// The network scores positions from white's point of view, like Engine::evaluate.
+class Nnue {
+public:
+    static bool load(const std::string& path);
+    static bool isLoaded();
+    // accumulator updates, used by Board::putPiece/takePiece
+    static void resetAccumulator(int16_t* accumulator);
+    static void addFeature(int16_t* accumulator, int feature);
+    static void removeFeature(int16_t* accumulator, int feature);
+    // runs the dense layers on top of an up to date accumulator
+    static int evaluate(const int16_t* accumulator);
+    // instruction set the kernels were compiled for
+    static const char* simdName();
+};
+
+#endif
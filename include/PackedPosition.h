@@ -0,0 +1,68 @@
+#ifndef PACKEDPOSITION_H
+#define PACKEDPOSITION_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// PackedPosition::score when the position has no score
+#define PACKED_NO_SCORE INT16_MIN
+
+// PackedPosition::result, from white's point of view
+enum PackedResult : uint8_t { BLACK_WINS, DRAW, WHITE_WINS, NO_RESULT };
+
+// PackedPosition::flags
+#define PACKED_BLACK_TO_MOVE 1
+// castling rights take bit PACKED_CASTLING_SHIFT + 2 * colorIndex() + kingSide
+#define PACKED_CASTLING_SHIFT 1
+
+// one position in 32 bytes, for datasets of millions of positions. Squares
+// are numbered row * 8 + col like Board, so a8 is 0. Each occupied square,
+// in square order, takes a nibble of pieces[] holding 1 + colorIndex() * 6 +
+// PieceType, the same code PositionBatch uses; the low nibble comes first.
+// Files are arrays of records in the machine's byte order, read in place.
+struct PackedPosition {
+    uint64_t occupied;
+    uint8_t pieces[16];
+    uint8_t flags;
+    // 1 + the file of the en passant target, 0 for none
+    uint8_t enPassant;
+    // clamped to 255
+    uint8_t halfmoveClock;
+    uint8_t result;
+    uint16_t fullmoveNumber;
+    // centipawns from white's point of view, PACKED_NO_SCORE when unknown
+    int16_t score;
+
+    // code of the index-th occupied square
+    int pieceCode(int index) const {
+        return (pieces[index / 2] >> ((index % 2) * 4)) & 15;
+    }
+    char sideToMove() const {
+        return (flags & PACKED_BLACK_TO_MOVE) ? 'B' : 'W';
+    }
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+PackedPosition packPosition(const Board& board, int score = PACKED_NO_SCORE, uint8_t result = NO_RESULT);
+
+// memory mapped file of PackedPosition records. Nothing is read up front,
+// positions are handed out as references into the mapping.
+class PackedDataset {
+private:
+    MappedFile file;
+    size_t count = 0;
+public:
+    // fails unless the file holds a whole number of records
+    bool open(const std::string& path);
+    bool isOpen() const;
+    size_t size() const;
+    const PackedPosition& operator[](size_t index) const;
+    const PackedPosition* begin() const;
+    const PackedPosition* end() const;
+};
+
+#endif
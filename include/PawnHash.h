@@ -0,0 +1,40 @@
+#ifndef PAWNHASH_H
+#define PAWNHASH_H
+
+#include "Board.h"
+#include <cstdint>
+#include <vector>
+
+// number of entries in a pawn hash table, must be a power of two
+#define PAWN_HASH_SIZE 16384
+
+// pawn structure terms and the bitboards derived from them, for one pawn configuration
+struct PawnEntry {
+    uint64_t key;
+    // doubled, isolated, backward and passed pawn terms, white minus black
+    Score score;
+    // indexed by colorIndex()
+    Bitboard passedPawns[2];
+    // squares the side's pawns attack now or could attack after advancing
+    Bitboard pawnAttackSpans[2];
+    // bit per file (bit 0 = file a) with no pawns at all
+    uint8_t openFiles;
+    // bit per file without pawns of the given side
+    uint8_t semiOpenFiles[2];
+};
+
+// cache of pawn structure evaluations keyed by Board::pawnKey, not thread
+// safe so each search thread keeps its own
+class PawnHashTable {
+private:
+    std::vector<PawnEntry> entries;
+    void evaluatePawns(const Board& board, PawnEntry& entry) const;
+public:
+    PawnHashTable();
+    // returns the entry for the board's pawns, evaluating them on a miss
+    const PawnEntry& probe(const Board& board);
+    // true when probe() would not have to evaluate the board's pawns
+    bool contains(const Board& board) const;
+};
+
+#endif
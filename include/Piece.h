@@ -2,9 +2,18 @@
 #define PIECE_H
 
 #include <string>
+#include <tuple>
 #include <vector>
 using namespace std;
 
+// index of a piece kind in evaluation tables
+enum PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+
+// 'W' -> 0, 'B' -> 1
+inline int colorIndex(char color) {
+    return color == 'W' ? 0 : 1;
+}
+
 class Piece {
 protected:
     // 'W' for white, 'B' for black
@@ -22,7 +31,12 @@ public:
 
     virtual bool isValidPieceMove(int startX, int startY, int endX, int endY, const vector<vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const = 0;
     virtual string getType() const = 0;
+    // same as getType() but cheap to compare, used on hot paths
+    virtual PieceType getPieceType() const = 0;
     virtual void makeMove() {};
+    // for pieces whose moves depend on whether they moved before, e.g. when
+    // a position is set up from a FEN
+    virtual void setMoved(bool) {}
 };
 
 #endif
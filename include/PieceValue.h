@@ -1,4 +1,16 @@
-const int pawnTable[8][8] = {
+#ifndef PIECEVALUE_H
+#define PIECEVALUE_H
+
+// material value indexed by PieceType
+const int pieceMiddleGameValues[6] = {100, 300, 300, 500, 900, 0};
+const int pieceEndGameValues[6] = {130, 290, 310, 530, 940, 0};
+
+// contribution of each piece to the game phase, 24 = all pieces on the board
+const int piecePhase[6] = {0, 1, 1, 2, 4, 0};
+
+// piece-square tables, row 0 is the owner's back rank
+
+const int pawnMiddleGameTable[8][8] = {
     { 0,   5,  5, -10, -10,  5,  5,  0},
     { 5,  10, 10,   0,   0, 10, 10,  5},
     {10,  10, 20,  20,  20, 20, 10, 10},
@@ -9,7 +21,18 @@ const int pawnTable[8][8] = {
     { 0,   5,  5, -10, -10,  5,  5,  0}
 };
 
-const int knightTable[8][8] = {
+const int pawnEndGameTable[8][8] = {
+    { 0,   0,  0,   0,   0,  0,  0,  0},
+    { 5,   5,  5,   5,   5,  5,  5,  5},
+    { 5,   5,  5,   5,   5,  5,  5,  5},
+    {10,  10, 10,  10,  10, 10, 10, 10},
+    {15,  15, 15,  15,  15, 15, 15, 15},
+    {20,  20, 20,  20,  20, 20, 20, 20},
+    {30,  30, 30,  30,  30, 30, 30, 30},
+    { 0,   0,  0,   0,   0,  0,  0,  0}
+};
+
+const int knightMiddleGameTable[8][8] = {
     {-50, -40, -30, -30, -30, -30, -40, -50},
     {-40, -20,   0,   5,   5,   0, -20, -40},
     {-30,   5,  10,  15,  15,  10,   5, -30},
@@ -20,7 +43,18 @@ const int knightTable[8][8] = {
     {-50, -40, -30, -30, -30, -30, -40, -50}
 };
 
-const int bishopTable[8][8] = {
+const int knightEndGameTable[8][8] = {
+    {-40, -30, -20, -20, -20, -20, -30, -40},
+    {-30, -15,   0,   0,   0,   0, -15, -30},
+    {-20,   0,  10,  15,  15,  10,   0, -20},
+    {-20,   5,  15,  20,  20,  15,   5, -20},
+    {-20,   5,  15,  20,  20,  15,   5, -20},
+    {-20,   0,  10,  15,  15,  10,   0, -20},
+    {-30, -15,   0,   0,   0,   0, -15, -30},
+    {-40, -30, -20, -20, -20, -20, -30, -40}
+};
+
+const int bishopMiddleGameTable[8][8] = {
     {-20, -10, -10, -10, -10, -10, -10, -20},
     {-10,   0,   0,   5,   5,   0,   0, -10},
     {-10,   0,  10,  10,  10,  10,   0, -10},
@@ -31,7 +65,18 @@ const int bishopTable[8][8] = {
     {-20, -10, -10, -10, -10, -10, -10, -20}
 };
 
-const int rookTable[8][8] = {
+const int bishopEndGameTable[8][8] = {
+    {-15, -10, -10, -10, -10, -10, -10, -15},
+    {-10,   0,   0,   0,   0,   0,   0, -10},
+    {-10,   0,   5,   5,   5,   5,   0, -10},
+    {-10,   0,   5,  10,  10,   5,   0, -10},
+    {-10,   0,   5,  10,  10,   5,   0, -10},
+    {-10,   0,   5,   5,   5,   5,   0, -10},
+    {-10,   0,   0,   0,   0,   0,   0, -10},
+    {-15, -10, -10, -10, -10, -10, -10, -15}
+};
+
+const int rookMiddleGameTable[8][8] = {
     { 0,   0,   0,   5,   5,   0,   0,   0},
     {-5,   0,   0,   0,   0,   0,   0,  -5},
     {-5,   0,   0,   0,   0,   0,   0,  -5},
@@ -42,7 +87,18 @@ const int rookTable[8][8] = {
     { 0,   0,   0,   5,   5,   0,   0,   0}
 };
 
-const int queenTable[8][8] = {
+const int rookEndGameTable[8][8] = {
+    { 0,   0,   0,   0,   0,   0,   0,   0},
+    { 0,   0,   0,   0,   0,   0,   0,   0},
+    { 0,   0,   0,   0,   0,   0,   0,   0},
+    { 0,   0,   0,   0,   0,   0,   0,   0},
+    { 5,   5,   5,   5,   5,   5,   5,   5},
+    { 5,   5,   5,   5,   5,   5,   5,   5},
+    {15,  15,  15,  15,  15,  15,  15,  15},
+    { 5,   5,   5,   5,   5,   5,   5,   5}
+};
+
+const int queenMiddleGameTable[8][8] = {
     {-20, -10, -10,  -5,  -5, -10, -10, -20},
     {-10,   0,   0,   0,   0,   0,   0, -10},
     {-10,   0,   5,   5,   5,   5,   0, -10},
@@ -53,6 +109,17 @@ const int queenTable[8][8] = {
     {-20, -10, -10,  -5,  -5, -10, -10, -20}
 };
 
+const int queenEndGameTable[8][8] = {
+    {-20, -15, -10, -10, -10, -10, -15, -20},
+    {-15,  -5,   0,   0,   0,   0,  -5, -15},
+    {-10,   0,  10,  10,  10,  10,   0, -10},
+    {-10,   0,  10,  20,  20,  10,   0, -10},
+    {-10,   0,  10,  20,  20,  10,   0, -10},
+    {-10,   0,  10,  10,  10,  10,   0, -10},
+    {-15,  -5,   0,   0,   0,   0,  -5, -15},
+    {-20, -15, -10, -10, -10, -10, -15, -20}
+};
+
 const int kingMiddleGameTable[8][8] = {
     { 20,  30,  10,   0,   0,  10,  30,  20},
     { 20,  20,   0,   0,   0,   0,  20,  20},
@@ -73,4 +140,6 @@ const int kingEndGameTable[8][8] = {
     {-30, -10,  20,  30,  30,  20, -10, -30},
     {-30, -30,   0,   0,   0,   0, -30, -30},
     {-50, -30, -30, -30, -30, -30, -30, -50}
-};
\ No newline at end of file
+};
+
+#endif
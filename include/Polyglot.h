@@ -0,0 +1,65 @@
+#ifndef POLYGLOT_H
+#define POLYGLOT_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Polyglot keys XOR 781 random numbers: 768 for pieces, 4 for castling
+// rights, 8 for the en passant file and 1 for white to move. The numbers
+// published with Polyglot are not built in; until loadPolyglotRandom()
+// reads them, keys come from our own table, which is fine for telling
+// positions apart but matches no book. Books are only opened and built
+// with the published numbers loaded.
+#define POLYGLOT_RANDOM_COUNT 781
+// key of the start position with the published numbers, from Polyglot's
+// book format description
+#define POLYGLOT_START_KEY 0x463B96181691FC9CULL
+
+// reads POLYGLOT_RANDOM_COUNT hexadecimal numbers written as 0x..., e.g.
+// the Random64 array from Polyglot's source, in order. Fails, keeping the
+// current numbers, when they do not give POLYGLOT_START_KEY.
+bool loadPolyglotRandom(const std::string& path);
+// whether loadPolyglotRandom() succeeded, so keys match Polyglot books
+bool polyglotRandomLoaded();
+uint64_t polyglotKey(const Board& board, char sideToMove);
+
+// a book move in Board coordinates, castling as the king's two-square move
+struct BookMove {
+    std::pair<int, int> from;
+    std::pair<int, int> to;
+    // 0 for none, otherwise the PieceType promoted to
+    int promotion;
+    uint16_t weight;
+};
+
+// converts between Polyglot's 16-bit move encoding and Board coordinates
+BookMove decodePolyglotMove(uint16_t move, const Board& board);
+uint16_t encodePolyglotMove(const BookMove& move, const Board& board);
+
+// Polyglot .bin book: 16-byte big-endian entries (key, move, weight,
+// learn) sorted by key. The file is memory mapped, so opening costs
+// nothing and a probe is a binary search touching a few pages.
+class PolyglotBook {
+private:
+    MappedFile file;
+    size_t entryCount = 0;
+    mutable std::mt19937 rng{std::random_device{}()};
+public:
+    // false when the file is not a book, or when the published random
+    // numbers are not loaded and no position could ever be found
+    bool open(const std::string& path);
+    bool isOpen() const;
+    size_t size() const;
+    // every move stored for the position
+    std::vector<BookMove> probe(const Board& board, char sideToMove) const;
+    // picks a move at random weighted by the book weights, or the
+    // heaviest one when bestOnly is set; false when out of book
+    bool pickMove(const Board& board, char sideToMove, bool bestOnly, BookMove& move) const;
+};
+
+#endif
@@ -9,6 +9,8 @@ public:
 
     string getType() const override;
 
+    PieceType getPieceType() const override;
+
     bool isValidPieceMove(int startX, int startY, int endX, int endY, const vector<vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const override;
     
     Piece* clone() const override {
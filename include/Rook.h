@@ -11,11 +11,14 @@ public:
 
     string getType() const override;
 
+    PieceType getPieceType() const override;
+
     bool canCastle() const;
 
     bool isValidPieceMove(int startX, int startY, int endX, int endY, const vector<vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const override;
 
     void makeMove() override;
+    void setMoved(bool moved) override;
 
     Piece* clone() const override {
         return new Rook(*this);
@@ -0,0 +1,28 @@
+#ifndef SAN_H
+#define SAN_H
+
+#include "Board.h"
+#include <string>
+
+// a move in Board coordinates
+struct SanMove {
+    int fromX;
+    int fromY;
+    int toX;
+    int toY;
+    // PieceType a pawn promotes to, QUEEN when not given
+    int promotion;
+};
+
+// finds the legal move a standard algebraic notation string (e.g. "Nbd7",
+// "exd5", "O-O", "e8=Q+") describes; false when it is malformed, ambiguous
+// or not legal for the side to move
+bool parseSan(Board& board, const std::string& san, char sideToMove, SanMove& move);
+
+// long algebraic notation as used by UCI, e.g. "e2e4" or "e7e8n"; parsing
+// only checks the syntax, not that the move is legal
+bool parseCoordinateMove(const std::string& text, SanMove& move);
+// a pawn reaching the last rank is written as a queen promotion
+std::string coordinateMove(const Board& board, int fromX, int fromY, int toX, int toY);
+
+#endif
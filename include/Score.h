@@ -0,0 +1,34 @@
+#ifndef SCORE_H
+#define SCORE_H
+
+#include <cstdint>
+
+// game phase of a position with every piece on the board
+#define MAX_PHASE 24
+
+// a middlegame and an endgame value packed into one int, the endgame
+// value in the upper 16 bits; packed scores can be added, subtracted
+// and multiplied by an int like plain ints
+typedef int Score;
+
+constexpr Score makeScore(int mg, int eg) {
+    return (int)((unsigned int)eg << 16) + mg;
+}
+
+constexpr int mgValue(Score score) {
+    return (int16_t)(uint16_t)(unsigned int)score;
+}
+
+constexpr int egValue(Score score) {
+    return (int16_t)(uint16_t)((unsigned int)(score + 0x8000) >> 16);
+}
+
+// interpolate between the middlegame and endgame value by game phase
+constexpr int taper(Score score, int phase) {
+    if (phase > MAX_PHASE) {
+        phase = MAX_PHASE;
+    }
+    return (mgValue(score) * phase + egValue(score) * (MAX_PHASE - phase)) / MAX_PHASE;
+}
+
+#endif
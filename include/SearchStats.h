@@ -0,0 +1,46 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// depths the statistics keep apart, deeper ones are counted with the last
+#define STATS_MAX_DEPTH 64
+
+// counters of one search, only collected when the engine is built with
+// SEARCH_STATS. Every search thread counts into its own copy, which is
+// added to the engine's total when the thread finishes, so counting never
+// touches shared memory.
+struct SearchStats {
+    // false when the engine was built without SEARCH_STATS, everything else is then zero
+    bool enabled = false;
+    // positions whose moves were searched, and the moves searched, by
+    // remaining depth; the ratio is the branching factor after cutoffs
+    uint64_t nodes[STATS_MAX_DEPTH] = {};
+    uint64_t moves[STATS_MAX_DEPTH] = {};
+    // nodes added by each iteration of iterative deepening, by its depth
+    uint64_t iterationNodes[STATS_MAX_DEPTH] = {};
+    uint64_t betaCutoffs = 0;
+    // cutoffs by the first legal move searched, a measure of move ordering
+    uint64_t firstMoveCutoffs = 0;
+    uint64_t evalCalls = 0;
+    uint64_t evalCacheHits = 0;
+    // classic evaluations that reached the lazy exit, and those settled
+    // there by material, piece-square and pawn terms alone
+    uint64_t lazyEvalCalls = 0;
+    uint64_t lazyExits = 0;
+    // pawn hash probes, one per lazy evaluation call, that found the entry
+    uint64_t pawnHashHits = 0;
+    // nanoseconds in getLegalMoves below the root and in evaluation
+    uint64_t moveGenTime = 0;
+    uint64_t evalTime = 0;
+
+    SearchStats& operator+=(const SearchStats& other);
+    void clear();
+    // a few lines of text, e.g. for a UCI "info string" each
+    void print(std::ostream& out) const;
+    std::string toJson() const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SEARCHTREE_H
+#define SEARCHTREE_H
+
+#include "Board.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// parent of the nodes directly below the root
+#define SEARCH_TREE_ROOT 0xFFFFFFFFu
+#define SEARCH_TREE_VERSION 1
+// from and to of a node without a move
+#define SEARCH_TREE_NO_SQUARE 0xFF
+
+// how Engine::minimax finished with a node
+enum SearchTreeReason : uint8_t {
+    // every legal move searched, none of them cut off; no moves means mate or stalemate
+    TREE_SEARCHED,
+    TREE_BETA_CUTOFF,
+    // depth 0, statically evaluated
+    TREE_LEAF,
+    // the search was stopped, the score is meaningless
+    TREE_STOPPED,
+    // dead draw by material or a drawn bitbase position
+    TREE_DRAW,
+    // won bitbase position at depth 0
+    TREE_BITBASE_WIN,
+};
+
+// one position visited by Engine::minimax, in the order they were entered.
+// Scores and bounds are from white's point of view, squares are row * 8 + col.
+struct SearchTreeNode {
+    // Polyglot key, includes side to move, castling and en passant
+    uint64_t key;
+    int32_t alpha;
+    int32_t beta;
+    int32_t score;
+    // index of the parent node, or SEARCH_TREE_ROOT
+    uint32_t parent;
+    // remaining depth
+    uint8_t depth;
+    // iteration of the search the node belongs to
+    uint8_t iteration;
+    // the move that led here
+    uint8_t from;
+    uint8_t to;
+    // legal moves searched; for a cutoff, the position of the move that cut
+    uint16_t movesSearched;
+    uint8_t reason;
+    // colorIndex() of the side to move
+    uint8_t side;
+};
+
+static_assert(sizeof(SearchTreeNode) == 32, "SearchTreeNode must stay 32 bytes");
+
+// file layout: this header, then count nodes, little-endian
+struct SearchTreeHeader {
+    char magic[4];  // "BFST"
+    uint32_t version;
+    uint64_t count;
+};
+
+// records the nodes of Engine::minimax into a preallocated array, from
+// any number of search threads without locking. Recording stops once the
+// array is full. Only one recorder may be attached to a running search.
+class SearchTreeRecorder {
+private:
+    std::vector<SearchTreeNode> nodes;
+    std::atomic<uint64_t> used{0};
+    // only the subtree below this root move is recorded, -1 for all
+    int subtreeFrom = -1;
+    int subtreeTo = -1;
+public:
+    explicit SearchTreeRecorder(size_t maxNodes);
+    void setSubtree(int from, int to);
+    // forgets the recorded nodes
+    void clear();
+    size_t size() const;
+    bool isFull() const;
+    const SearchTreeNode* data() const;
+    bool write(const std::string& path) const;
+
+    // called by the engine when a search thread starts on a root move
+    void beginRootMove(int iteration, int from, int to);
+    // the node being entered, or nullptr when it is not recorded; every
+    // non-null result must be passed to leave() once the node is done
+    SearchTreeNode* enter(const Board& board, char currentPlayer, int depth, int alpha, int beta);
+    void leave(SearchTreeNode* node, int score);
+};
+
+// reads a file written by SearchTreeRecorder::write; false for files that
+// are cut short or whose parents do not come before their children
+bool readSearchTree(const std::string& path, std::vector<SearchTreeNode>& nodes);
+
+#endif
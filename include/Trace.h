@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// events kept per thread, older ones are overwritten
+#define TRACE_BUFFER_EVENTS 16384
+
+// opt-in timeline of the search: named spans recorded per thread and
+// written as Chrome trace-event JSON, which Perfetto (ui.perfetto.dev) and
+// chrome://tracing open offline. Every thread writes to its own ring
+// buffer without locking; buffers of finished threads are handed to the
+// next new thread, which shows up as the same timeline row. While tracing
+// is off a span costs one relaxed atomic load.
+class Trace {
+private:
+    static std::atomic<bool> enabled;
+public:
+    // starts recording, dropping what was recorded before
+    static void start();
+    static void stop();
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    // all recorded events; call while no spans are being recorded, e.g.
+    // between searches, or events being written may come out garbled
+    static bool write(const std::string& path);
+    // row label for the calling thread's events, name must outlive the trace
+    static void setThreadName(const char* name);
+    // a finished span; name must be a string literal, detail is cut to 7 characters
+    static void record(const char* name, uint64_t start, uint64_t end, int64_t value, const char* detail);
+    // nanoseconds on the trace's clock
+    static uint64_t now();
+};
+
+// records the time from construction to destruction as one span. value
+// and detail are shown as the span's arguments, value only when not -1.
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start;
+    int64_t value;
+    char detail[8];
+public:
+    explicit TraceSpan(const char* name, int64_t value = -1, const char* text = nullptr) : name(nullptr) {
+        if (Trace::isEnabled()) {
+            this->name = name;
+            this->value = value;
+            int i = 0;
+            for (; text && text[i] && i < 7; i++) {
+                detail[i] = text[i];
+            }
+            detail[i] = 0;
+            start = Trace::now();
+        }
+    }
+    ~TraceSpan() {
+        if (name) {
+            Trace::record(name, start, Trace::now(), value, detail);
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif
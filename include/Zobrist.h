@@ -0,0 +1,38 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// random keys for hashing positions, generated at compile time so every
+// build and every run hashes positions the same way
+struct ZobristTable {
+    // indexed by colorIndex(), PieceType and square
+    uint64_t pieces[2][6][64];
+    // starting value of the pawn key, so positions without pawns do not hash to 0
+    uint64_t noPawns;
+};
+
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristTable buildZobristTable() {
+    ZobristTable table{};
+    uint64_t state = 0x42616446697368ULL;
+    for (int c = 0; c < 2; c++) {
+        for (int type = 0; type < 6; type++) {
+            for (int square = 0; square < 64; square++) {
+                table.pieces[c][type][square] = splitMix64(state);
+            }
+        }
+    }
+    table.noPawns = splitMix64(state);
+    return table;
+}
+
+inline constexpr ZobristTable zobrist = buildZobristTable();
+
+#endif
@@ -0,0 +1,144 @@
+#include "BatchEval.h"
+#include "PieceValue.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BATCH_AVX2
+#endif
+
+// piece-square scores and phase weights indexed by piece code, code 0 is
+// an empty square and scores nothing, so empty squares need no branch
+struct BatchTables {
+    alignas(32) Score scores[13][64];
+    alignas(32) int phase[13];
+};
+
+static const BatchTables& batchTables() {
+    static const BatchTables tables = [] {
+        BatchTables t{};
+        for (int c = 0; c < 2; c++) {
+            for (int type = PAWN; type <= KING; type++) {
+                int code = 1 + c * 6 + type;
+                for (int square = 0; square < 64; square++) {
+                    t.scores[code][square] = Board::pieceSquareScore(c, type, square);
+                }
+                t.phase[code] = piecePhase[type];
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+void PositionBatch::add(const Board& board) {
+    // grow a whole SIMD step at a time so the padding lanes stay empty
+    if (count % BATCH_LANES == 0) {
+        for (auto& square : squares) {
+            square.resize(count + BATCH_LANES, 0);
+        }
+    }
+    for (int c = 0; c < 2; c++) {
+        for (int type = PAWN; type <= KING; type++) {
+            Bitboard pieces = board.pieceBitboards[c][type];
+            while (pieces) {
+                squares[popLsb(pieces)][count] = 1 + c * 6 + type;
+            }
+        }
+    }
+    count++;
+}
+
+void PositionBatch::add(const PackedPosition& packed) {
+    if (count % BATCH_LANES == 0) {
+        for (auto& square : squares) {
+            square.resize(count + BATCH_LANES, 0);
+        }
+    }
+    Bitboard occupied = packed.occupied;
+    for (int index = 0; occupied && index < 32; index++) {
+        squares[popLsb(occupied)][count] = packed.pieceCode(index);
+    }
+    count++;
+}
+
+void PositionBatch::clear() {
+    for (auto& square : squares) {
+        square.clear();
+    }
+    count = 0;
+}
+
+size_t PositionBatch::size() const {
+    return count;
+}
+
+uint8_t PositionBatch::pieceCode(size_t position, int square) const {
+    return squares[square][position];
+}
+
+const char* PositionBatch::simdName() {
+#if defined(BATCH_AVX2)
+    return "AVX2";
+#else
+    return "scalar";
+#endif
+}
+
+void PositionBatch::evaluateScalar(std::vector<int>& scores) const {
+    const BatchTables& tables = batchTables();
+    scores.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        Score psq = 0;
+        int phase = 0;
+        for (int square = 0; square < 64; square++) {
+            uint8_t code = squares[square][i];
+            psq += tables.scores[code][square];
+            phase += tables.phase[code];
+        }
+        scores[i] = taper(psq, phase);
+    }
+}
+
+void PositionBatch::evaluate(std::vector<int>& scores) const {
+#if defined(BATCH_AVX2)
+    const BatchTables& tables = batchTables();
+    const int* scoreTable = &tables.scores[0][0];
+    const __m256i maxPhase = _mm256_set1_epi32(MAX_PHASE);
+    const __m256d divisor = _mm256_set1_pd(MAX_PHASE);
+    alignas(16) int8_t phaseBytes[16] = {};
+    for (int code = 0; code < 13; code++) {
+        phaseBytes[code] = tables.phase[code];
+    }
+    const __m256i phaseTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(phaseBytes)));
+    // room for the padding lanes, trimmed again below
+    scores.resize(squares[0].size());
+    for (size_t base = 0; base < count; base += BATCH_LANES) {
+        __m256i psq = _mm256_setzero_si256();
+        __m256i phase = _mm256_setzero_si256();
+        for (int square = 0; square < 64; square++) {
+            __m256i codes = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&squares[square][base])));
+            __m256i index = _mm256_add_epi32(_mm256_slli_epi32(codes, 6), _mm256_set1_epi32(square));
+            psq = _mm256_add_epi32(psq, _mm256_i32gather_epi32(scoreTable, index, 4));
+            // codes are below 16 and the upper bytes of each lane are zero, so a
+            // byte shuffle looks up the phase weight without a second gather
+            phase = _mm256_add_epi32(phase, _mm256_shuffle_epi8(phaseTable, codes));
+        }
+        // same unpacking and interpolation as taper() in Score.h
+        phase = _mm256_min_epi32(phase, maxPhase);
+        __m256i mg = _mm256_srai_epi32(_mm256_slli_epi32(psq, 16), 16);
+        __m256i eg = _mm256_srai_epi32(_mm256_add_epi32(psq, _mm256_set1_epi32(0x8000)), 16);
+        __m256i sum = _mm256_add_epi32(_mm256_mullo_epi32(mg, phase),
+                                       _mm256_mullo_epi32(eg, _mm256_sub_epi32(maxPhase, phase)));
+        // no integer division in AVX2, sums stay far below 2^53 so dividing
+        // in double and truncating gives the same result as the int division
+        __m128i low = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sum)), divisor));
+        __m128i high = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sum, 1)), divisor));
+        __m256i result = _mm256_setr_m128i(low, high);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&scores[base]), result);
+    }
+    scores.resize(count);
+#else
+    evaluateScalar(scores);
+#endif
+}
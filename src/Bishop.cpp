@@ -4,6 +4,10 @@ Bishop::Bishop(char color) : Piece(color) {}
 
 string Bishop::getType() const { return "Bishop"; }
 
+PieceType Bishop::getPieceType() const {
+    return BISHOP;
+}
+
 bool Bishop::isValidPieceMove(int startX, int startY, int endX, int endY, const vector<vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const {
     int dx = abs(endX - startX);
     int dy = abs(endY - startY);
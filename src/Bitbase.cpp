@@ -0,0 +1,59 @@
+#include "Bitbase.h"
+#include "MappedFile.h"
+#include <cstring>
+
+// indexed by the PieceType of the strong side's extra piece, only pawn,
+// rook and queen have a file
+static MappedFile bitbaseFiles[6];
+
+static bool openBitbase(MappedFile& file, const std::string& path) {
+    if (!file.open(path)) {
+        return false;
+    }
+    uint32_t version;
+    if (file.size() != BITBASE_HEADER_SIZE + BITBASE_POSITIONS / 8 ||
+        std::memcmp(file.data(), "BFBB", 4) != 0) {
+        file.close();
+        return false;
+    }
+    std::memcpy(&version, file.data() + 4, sizeof(version));
+    if (version != 1) {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+int loadBitbases(const std::string& directory) {
+    const std::pair<PieceType, const char*> names[] = {{PAWN, "kpk.bb"}, {ROOK, "krk.bb"}, {QUEEN, "kqk.bb"}};
+    int loaded = 0;
+    for (const auto& [type, name] : names) {
+        if (openBitbase(bitbaseFiles[type], directory + "/" + name)) {
+            loaded++;
+        }
+    }
+    return loaded;
+}
+
+BitbaseResult probeBitbase(const Board& board, int sideToMove, int& strongSide) {
+    if (popcount(board.colorBitboards[0] | board.colorBitboards[1]) != 3) {
+        return BITBASE_UNKNOWN;
+    }
+    strongSide = popcount(board.colorBitboards[0]) == 2 ? 0 : 1;
+    int type = PAWN;
+    while (type < KING && !board.pieceBitboards[strongSide][type]) {
+        type++;
+    }
+    const MappedFile& file = bitbaseFiles[type];
+    if (!file.isOpen()) {
+        return BITBASE_UNKNOWN;
+    }
+    // flipping the rows turns a black-strong position into a white-strong one
+    int flip = (strongSide == 0) ? 0 : 56;
+    int index = bitbaseIndex(sideToMove == strongSide,
+                             lsb(board.pieceBitboards[strongSide][KING]) ^ flip,
+                             lsb(board.pieceBitboards[strongSide ^ 1][KING]) ^ flip,
+                             lsb(board.pieceBitboards[strongSide][type]) ^ flip);
+    const uint8_t* bits = file.data() + BITBASE_HEADER_SIZE;
+    return (bits[index >> 3] >> (index & 7)) & 1 ? BITBASE_WIN : BITBASE_DRAW;
+}
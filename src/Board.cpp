@@ -8,8 +8,46 @@
 #include "Piece.h"
 #include "Queen.h"
 #include "Rook.h"
+#include "PieceValue.h"
+#include "PackedPosition.h"
 #include <typeinfo>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+// packed material + piece-square score of every piece on every square,
+// from white's point of view
+struct PieceSquareTable {
+    Score scores[2][6][64];
+};
+
+static constexpr PieceSquareTable buildPieceSquareTable() {
+    const int (*middleGame[6])[8] = {pawnMiddleGameTable, knightMiddleGameTable, bishopMiddleGameTable,
+                                     rookMiddleGameTable, queenMiddleGameTable, kingMiddleGameTable};
+    const int (*endGame[6])[8] = {pawnEndGameTable, knightEndGameTable, bishopEndGameTable,
+                                  rookEndGameTable, queenEndGameTable, kingEndGameTable};
+    PieceSquareTable table{};
+    for (int type = PAWN; type <= KING; type++) {
+        for (int i = 0; i < 8; i++) {
+            for (int j = 0; j < 8; j++) {
+                // tables are written from the owner's back rank, which is row 7 for white
+                int whiteRow = 7 - i;
+                int blackRow = i;
+                table.scores[0][type][i * 8 + j] = makeScore(
+                    pieceMiddleGameValues[type] + middleGame[type][whiteRow][j],
+                    pieceEndGameValues[type] + endGame[type][whiteRow][j]);
+                table.scores[1][type][i * 8 + j] = -makeScore(
+                    pieceMiddleGameValues[type] + middleGame[type][blackRow][j],
+                    pieceEndGameValues[type] + endGame[type][blackRow][j]);
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr PieceSquareTable pieceSquareTable = buildPieceSquareTable();
 
 Board::Board() {
     board = vector<vector<Piece*>>(8, vector<Piece*>(8, nullptr));
@@ -26,8 +64,28 @@ Board::~Board() {
 
 // copy constructor
 Board::Board(const Board& other) {
-    // deep copy of board
-    board.resize(8, vector<Piece*>(8, nullptr));
+    copyFrom(other);
+}
+
+// copy assignment operator
+Board& Board::operator=(const Board& other) {
+    if (this != &other) {
+        // free existing resources
+        for (auto& row : board) {
+            for (auto& piece : row) {
+                // clean up existing pointers
+                delete piece;
+            }
+        }
+        copyFrom(other);
+    }
+    return *this;
+}
+
+// deep copy shared by the copy constructor and assignment
+void Board::copyFrom(const Board& other) {
+    // resize and deep copy board
+    board.assign(8, vector<Piece*>(8, nullptr));
     for (int i = 0; i < 8; ++i) {
         for (int j = 0; j < 8; ++j) {
             if (other.board[i][j]) {
@@ -43,42 +101,172 @@ Board::Board(const Board& other) {
     enPassantTarget = other.enPassantTarget;
     whiteCastlingRights = other.whiteCastlingRights;
     blackCastlingRights = other.blackCastlingRights;
+    halfmoveClock = other.halfmoveClock;
+    fullmoveNumber = other.fullmoveNumber;
+    previousMove = other.previousMove;
     whiteKing = other.whiteKing;
     blackKing = other.blackKing;
+    psqScore = other.psqScore;
+    gamePhase = other.gamePhase;
+    for (int c = 0; c < 2; ++c) {
+        for (int type = PAWN; type <= KING; ++type) {
+            pieceBitboards[c][type] = other.pieceBitboards[c][type];
+        }
+        colorBitboards[c] = other.colorBitboards[c];
+    }
+    pawnKey = other.pawnKey;
+    hashKey = other.hashKey;
+    materialKey = other.materialKey;
+    std::memcpy(accumulator, other.accumulator, sizeof(accumulator));
 }
 
-// copy assignment operator
-Board& Board::operator=(const Board& other) {
-    if (this != &other) {
-        // free existing resources
-        for (auto& row : board) {
-            for (auto& piece : row) {
-                // clean up existing pointers
-                delete piece;
+// place a piece on an empty square, updating the running totals
+void Board::putPiece(int row, int col, Piece* piece) {
+    board[row][col] = piece;
+    if (!piece) {
+        return;
+    }
+    PieceType type = piece->getPieceType();
+    int c = colorIndex(piece->getColor());
+    psqScore += pieceSquareTable.scores[c][type][row * 8 + col];
+    gamePhase += piecePhase[type];
+    pieceBitboards[c][type] |= squareBit(row, col);
+    colorBitboards[c] |= squareBit(row, col);
+    hashKey ^= zobrist.pieces[c][type][row * 8 + col];
+    materialKey += materialKeyUnit(c, type);
+    if (type == PAWN) {
+        pawnKey ^= zobrist.pieces[c][PAWN][row * 8 + col];
+    }
+    if (Nnue::isLoaded()) {
+        Nnue::addFeature(accumulator, nnueFeature(c, type, row * 8 + col));
+    }
+}
+
+// lift a piece off its square, updating the running totals
+Piece* Board::takePiece(int row, int col) {
+    Piece* piece = board[row][col];
+    board[row][col] = nullptr;
+    if (!piece) {
+        return nullptr;
+    }
+    PieceType type = piece->getPieceType();
+    int c = colorIndex(piece->getColor());
+    psqScore -= pieceSquareTable.scores[c][type][row * 8 + col];
+    gamePhase -= piecePhase[type];
+    pieceBitboards[c][type] &= ~squareBit(row, col);
+    colorBitboards[c] &= ~squareBit(row, col);
+    hashKey ^= zobrist.pieces[c][type][row * 8 + col];
+    materialKey -= materialKeyUnit(c, type);
+    if (type == PAWN) {
+        pawnKey ^= zobrist.pieces[c][PAWN][row * 8 + col];
+    }
+    if (Nnue::isLoaded()) {
+        Nnue::removeFeature(accumulator, nnueFeature(c, type, row * 8 + col));
+    }
+    return piece;
+}
+
+// full recomputation of the running totals from the board
+void Board::computeScores(Score& psq, int& phase) const {
+    psq = 0;
+    phase = 0;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            Piece* piece = board[i][j];
+            if (piece) {
+                PieceType type = piece->getPieceType();
+                psq += pieceSquareTable.scores[colorIndex(piece->getColor())][type][i * 8 + j];
+                phase += piecePhase[type];
             }
         }
+    }
+}
+
+Score Board::pieceSquareScore(int color, int type, int square) {
+    return pieceSquareTable.scores[color][type][square];
+}
 
-        // resize and deep copy board
-        board.resize(8, vector<Piece*>(8, nullptr));
-        for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                if (other.board[i][j]) {
-                    board[i][j] = other.board[i][j]->clone();
+void Board::refreshState() {
+    computeScores(psqScore, gamePhase);
+    for (int c = 0; c < 2; ++c) {
+        for (int type = PAWN; type <= KING; ++type) {
+            pieceBitboards[c][type] = 0;
+        }
+        colorBitboards[c] = 0;
+    }
+    pawnKey = zobrist.noPawns;
+    hashKey = 0;
+    materialKey = 0;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            Piece* piece = board[i][j];
+            if (piece) {
+                int c = colorIndex(piece->getColor());
+                PieceType type = piece->getPieceType();
+                pieceBitboards[c][type] |= squareBit(i, j);
+                colorBitboards[c] |= squareBit(i, j);
+                hashKey ^= zobrist.pieces[c][type][i * 8 + j];
+                materialKey += materialKeyUnit(c, type);
+                if (type == PAWN) {
+                    pawnKey ^= zobrist.pieces[c][PAWN][i * 8 + j];
                 }
             }
         }
+    }
+    refreshAccumulator();
+}
 
-        // copy other members
-        isBlackInCheck = other.isBlackInCheck;
-        isWhiteInCheck = other.isWhiteInCheck;
-        currentPlayer = other.currentPlayer;
-        enPassantTarget = other.enPassantTarget;
-        whiteCastlingRights = other.whiteCastlingRights;
-        blackCastlingRights = other.blackCastlingRights;
-        whiteKing = other.whiteKing;
-        blackKing = other.blackKing;
+// rebuild the NNUE accumulator from scratch, e.g. after weights were loaded
+void Board::refreshAccumulator() {
+    if (!Nnue::isLoaded()) {
+        return;
     }
-    return *this;
+    Nnue::resetAccumulator(accumulator);
+    for (int c = 0; c < 2; ++c) {
+        for (int type = PAWN; type <= KING; ++type) {
+            Bitboard pieces = pieceBitboards[c][type];
+            while (pieces) {
+                Nnue::addFeature(accumulator, nnueFeature(c, type, popLsb(pieces)));
+            }
+        }
+    }
+}
+
+bool Board::verifyState() const {
+    Board fresh(*this);
+    fresh.refreshState();
+    bool ok = true;
+    if (fresh.psqScore != psqScore || fresh.gamePhase != gamePhase) {
+        std::cerr << "Incremental score mismatch: mg " << mgValue(psqScore) << " vs " << mgValue(fresh.psqScore)
+            << ", eg " << egValue(psqScore) << " vs " << egValue(fresh.psqScore)
+            << ", phase " << gamePhase << " vs " << fresh.gamePhase << std::endl;
+        ok = false;
+    }
+    for (int c = 0; c < 2; ++c) {
+        for (int type = PAWN; type <= KING; ++type) {
+            if (fresh.pieceBitboards[c][type] != pieceBitboards[c][type]) {
+                std::cerr << "Incremental bitboard mismatch: color " << c << ", type " << type << std::endl;
+                ok = false;
+            }
+        }
+        if (fresh.colorBitboards[c] != colorBitboards[c]) {
+            std::cerr << "Incremental bitboard mismatch: color " << c << std::endl;
+            ok = false;
+        }
+    }
+    if (fresh.pawnKey != pawnKey || fresh.hashKey != hashKey) {
+        std::cerr << "Incremental hash key mismatch" << std::endl;
+        ok = false;
+    }
+    if (fresh.materialKey != materialKey) {
+        std::cerr << "Incremental material key mismatch" << std::endl;
+        ok = false;
+    }
+    if (Nnue::isLoaded() && std::memcmp(fresh.accumulator, accumulator, sizeof(accumulator)) != 0) {
+        std::cerr << "Incremental NNUE accumulator mismatch" << std::endl;
+        ok = false;
+    }
+    return ok;
 }
 
 // deprecated, use loadFromFEN instead
@@ -114,75 +302,416 @@ void Board::initialise() {
     // kings
     board[0][4] = new King('B');
     board[7][4] = new King('W');
+    refreshState();
+}
+
+// new piece of a PieceType; promotions to anything but a minor piece or rook become a queen
+static Piece* createPiece(int type, char color) {
+    switch (type) {
+        case PAWN: return new Pawn(color);
+        case KNIGHT: return new Knight(color);
+        case BISHOP: return new Bishop(color);
+        case ROOK: return new Rook(color);
+        case KING: return new King(color);
+        default: return new Queen(color);
+    }
 }
 
-void Board::loadFromFEN(string fen) {
-    std::istringstream fenStream(fen);
-    std::string piecePlacement, activeColor, castlingRights, enPassantSquare, halfmoveClock, fullmoveNumber;
+static const char pieceLetters[] = "PNBRQK";
+// castling letters in PositionFields::castling order
+static const char castlingLetters[] = "QKqk";
 
-    // split the FEN string into its components
-    fenStream >> piecePlacement >> activeColor >> castlingRights >> enPassantSquare >> halfmoveClock >> fullmoveNumber;
+// a position taken apart, from a FEN string or a packed record; filled
+// completely before the board is touched, so bad input leaves the board as it was
+struct PositionFields {
+    // 1 + colour * 6 + PieceType, 0 for empty, indexed by row * 8 + col
+    uint8_t squares[64];
+    Bitboard pieces[2][6];
+    char side;
+    // [colour][queen side, king side]
+    bool castling[2][2];
+    // square the en passant capture lands on, -1 for none
+    int enPassantRow;
+    int enPassantCol;
+    int halfmoveClock;
+    int fullmoveNumber;
+};
 
-    // reset the board
-    board = vector<vector<Piece*>>(8, vector<Piece*>(8, nullptr));
+// PositionFields::squares code of every FEN piece letter, 0 for anything else
+static constexpr std::array<uint8_t, 256> buildPieceCodes() {
+    std::array<uint8_t, 256> codes{};
+    for (int type = PAWN; type <= KING; type++) {
+        codes[(unsigned char)"PNBRQK"[type]] = 1 + type;
+        codes[(unsigned char)"pnbrqk"[type]] = 7 + type;
+    }
+    return codes;
+}
+
+static constexpr std::array<uint8_t, 256> pieceCodes = buildPieceCodes();
+
+static void skipSpaces(std::string_view fen, size_t& i) {
+    while (i < fen.size() && (fen[i] == ' ' || fen[i] == '\t')) {
+        i++;
+    }
+}
+
+static bool parseNumber(std::string_view fen, size_t& i, int& value) {
+    if (i >= fen.size() || fen[i] < '0' || fen[i] > '9') {
+        return false;
+    }
+    value = 0;
+    while (i < fen.size() && fen[i] >= '0' && fen[i] <= '9') {
+        if (value > 100000) {
+            return false;
+        }
+        value = value * 10 + (fen[i++] - '0');
+    }
+    return true;
+}
+
+// rejects impossible positions and drops castling and en passant rights the
+// pieces do not allow
+static bool checkFields(PositionFields& fields) {
+    if (popcount(fields.pieces[0][KING]) != 1 || popcount(fields.pieces[1][KING]) != 1) {
+        return false;
+    }
+    // pawns never stand on the first or last rank
+    const Bitboard backRanks = 0xFF000000000000FFULL;
+    if ((fields.pieces[0][PAWN] | fields.pieces[1][PAWN]) & backRanks) {
+        return false;
+    }
+
+    // castling rights are only kept when the king and rook are on their home squares
+    for (int c = 0; c < 2; c++) {
+        int homeRow = (c == 0) ? 7 : 0;
+        for (int kingSide = 0; kingSide < 2; kingSide++) {
+            fields.castling[c][kingSide] = fields.castling[c][kingSide] &&
+                fields.squares[homeRow * 8 + 4] == 1 + c * 6 + KING &&
+                fields.squares[homeRow * 8 + (kingSide ? 7 : 0)] == 1 + c * 6 + ROOK;
+        }
+    }
+
+    // the en passant target is only kept with the pawn that just moved in front of it
+    if (fields.enPassantRow >= 0) {
+        int pawnRow = (fields.side == 'W') ? 3 : 4;
+        int them = (fields.side == 'W') ? 1 : 0;
+        if (fields.squares[pawnRow * 8 + fields.enPassantCol] != 1 + them * 6 + PAWN ||
+            fields.squares[fields.enPassantRow * 8 + fields.enPassantCol]) {
+            fields.enPassantRow = fields.enPassantCol = -1;
+        }
+    }
 
-    // parse piece placement
+    // the side that just moved cannot be in check
+    Bitboard occupied = 0;
+    for (int c = 0; c < 2; c++) {
+        for (int type = PAWN; type <= KING; type++) {
+            occupied |= fields.pieces[c][type];
+        }
+    }
+    int moved = (fields.side == 'W') ? 1 : 0;
+    int mover = moved ^ 1;
+    int kingSquare = lsb(fields.pieces[moved][KING]);
+    const Bitboard (&attackers)[6] = fields.pieces[mover];
+    if ((attackTables.pawn[moved][kingSquare] & attackers[PAWN]) ||
+        (attackTables.knight[kingSquare] & attackers[KNIGHT]) ||
+        (attackTables.king[kingSquare] & attackers[KING]) ||
+        (bishopAttacks(kingSquare, occupied) & (attackers[BISHOP] | attackers[QUEEN])) ||
+        (rookAttacks(kingSquare, occupied) & (attackers[ROOK] | attackers[QUEEN]))) {
+        return false;
+    }
+    return true;
+}
+
+static bool parseFen(std::string_view fen, PositionFields& fields) {
+    std::memset(&fields, 0, sizeof(fields));
+    size_t i = 0;
+    skipSpaces(fen, i);
+
+    // piece placement, rank 8 first
     int row = 0, col = 0;
-    for (char ch : piecePlacement) {
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char ch = fen[i];
         if (ch == '/') {
-            // move to the next row
-            row++;
+            if (col != 8 || ++row > 7) {
+                return false;
+            }
             col = 0;
-        } else if (isdigit(ch)) {
-            // empty squares
+        } else if (ch >= '1' && ch <= '8') {
             col += ch - '0';
+            if (col > 8) {
+                return false;
+            }
         } else {
-            // place a piece
-            char color = isupper(ch) ? 'W' : 'B';
-            // normalize to lowercase for type checking
-            ch = tolower(ch);
-            switch (ch) {
-                case 'p': board[row][col] = new Pawn(color); break;
-                case 'r': board[row][col] = new Rook(color); break;
-                case 'n': board[row][col] = new Knight(color); break;
-                case 'b': board[row][col] = new Bishop(color); break;
-                case 'q': board[row][col] = new Queen(color); break;
-                case 'k': 
-                    board[row][col] = new King(color); 
-                    if (color == 'W') whiteKing = {row, col};
-                    else blackKing = {row, col};
-                    break;
+            uint8_t code = pieceCodes[(unsigned char)ch];
+            if (!code || col > 7) {
+                return false;
             }
+            fields.squares[row * 8 + col] = code;
+            fields.pieces[(code - 1) / 6][(code - 1) % 6] |= squareBit(row, col);
             col++;
         }
     }
+    if (row != 7 || col != 8) {
+        return false;
+    }
+
+    // side to move
+    skipSpaces(fen, i);
+    if (i >= fen.size() || (fen[i] != 'w' && fen[i] != 'b')) {
+        return false;
+    }
+    fields.side = (fen[i++] == 'w') ? 'W' : 'B';
+
+    // castling rights
+    skipSpaces(fen, i);
+    if (i < fen.size() && fen[i] == '-') {
+        i++;
+    } else {
+        size_t startOfField = i;
+        for (; i < fen.size() && fen[i] != ' '; i++) {
+            const char* letter = std::strchr(castlingLetters, fen[i]);
+            if (!letter || *letter == 0) {
+                return false;
+            }
+            fields.castling[(letter - castlingLetters) / 2][(letter - castlingLetters) % 2] = true;
+        }
+        if (i == startOfField) {
+            return false;
+        }
+    }
 
-    // parse active color
-    if (activeColor == "w") {
-        currentPlayer = 'W';
+    // en passant target
+    skipSpaces(fen, i);
+    fields.enPassantRow = fields.enPassantCol = -1;
+    if (i < fen.size() && fen[i] == '-') {
+        i++;
     } else {
-        currentPlayer = 'B';
+        if (i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h' ||
+            fen[i + 1] != (fields.side == 'W' ? '6' : '3')) {
+            return false;
+        }
+        fields.enPassantRow = (fields.side == 'W') ? 2 : 5;
+        fields.enPassantCol = fen[i] - 'a';
+        i += 2;
+    }
+
+    // move counters, EPD lines leave them out
+    fields.halfmoveClock = 0;
+    fields.fullmoveNumber = 1;
+    skipSpaces(fen, i);
+    if (i < fen.size() && !parseNumber(fen, i, fields.halfmoveClock)) {
+        return false;
+    }
+    skipSpaces(fen, i);
+    if (i < fen.size() && (!parseNumber(fen, i, fields.fullmoveNumber) || fields.fullmoveNumber < 1)) {
+        return false;
+    }
+    skipSpaces(fen, i);
+    return i == fen.size() && checkFields(fields);
+}
+
+bool Board::loadFromFEN(std::string_view fen) {
+    PositionFields fields;
+    if (!parseFen(fen, fields)) {
+        return false;
+    }
+    setPosition(fields);
+    return true;
+}
+
+bool Board::loadPacked(const PackedPosition& packed) {
+    PositionFields fields;
+    std::memset(&fields, 0, sizeof(fields));
+    Bitboard occupied = packed.occupied;
+    if (popcount(occupied) > 32) {
+        return false;
+    }
+    for (int index = 0; occupied; index++) {
+        int square = popLsb(occupied);
+        int code = packed.pieceCode(index);
+        if (code < 1 || code > 12) {
+            return false;
+        }
+        fields.squares[square] = code;
+        fields.pieces[(code - 1) / 6][(code - 1) % 6] |= Bitboard(1) << square;
+    }
+    fields.side = packed.sideToMove();
+    for (int c = 0; c < 2; c++) {
+        for (int kingSide = 0; kingSide < 2; kingSide++) {
+            fields.castling[c][kingSide] = (packed.flags >> (PACKED_CASTLING_SHIFT + 2 * c + kingSide)) & 1;
+        }
+    }
+    fields.enPassantRow = fields.enPassantCol = -1;
+    if (packed.enPassant > 8) {
+        return false;
+    } else if (packed.enPassant) {
+        fields.enPassantRow = (fields.side == 'W') ? 2 : 5;
+        fields.enPassantCol = packed.enPassant - 1;
+    }
+    fields.halfmoveClock = packed.halfmoveClock;
+    fields.fullmoveNumber = std::max<int>(packed.fullmoveNumber, 1);
+    if (!checkFields(fields)) {
+        return false;
+    }
+    setPosition(fields);
+    return true;
+}
+
+void Board::setPosition(const PositionFields& fields) {
+    // the old pieces are reused where the new position has the same kind,
+    // so reloading similar positions allocates nothing
+    Piece* spare[2][6][64];
+    int spareCount[2][6] = {};
+    for (auto& row : board) {
+        for (auto& piece : row) {
+            if (piece) {
+                int c = colorIndex(piece->getColor());
+                PieceType type = piece->getPieceType();
+                spare[c][type][spareCount[c][type]++] = piece;
+                piece = nullptr;
+            }
+        }
+    }
+    // the running totals come straight from the parsed squares, refreshState()
+    // would walk the board again through virtual calls
+    psqScore = 0;
+    gamePhase = 0;
+    pawnKey = zobrist.noPawns;
+    hashKey = 0;
+    materialKey = 0;
+    for (int c = 0; c < 2; c++) {
+        colorBitboards[c] = 0;
+        for (int type = PAWN; type <= KING; type++) {
+            pieceBitboards[c][type] = fields.pieces[c][type];
+            colorBitboards[c] |= fields.pieces[c][type];
+        }
+    }
+    for (int square = 0; square < 64; square++) {
+        if (!fields.squares[square]) {
+            continue;
+        }
+        int c = (fields.squares[square] - 1) / 6;
+        int type = (fields.squares[square] - 1) % 6;
+        psqScore += pieceSquareTable.scores[c][type][square];
+        gamePhase += piecePhase[type];
+        hashKey ^= zobrist.pieces[c][type][square];
+        materialKey += materialKeyUnit(c, type);
+        if (type == PAWN) {
+            pawnKey ^= zobrist.pieces[c][PAWN][square];
+        }
+        char color = (c == 0) ? 'W' : 'B';
+        Piece* piece = spareCount[c][type] ? spare[c][type][--spareCount[c][type]] : createPiece(type, color);
+        int row = square / 8, col = square % 8;
+        int homeRow = (c == 0) ? 7 : 0;
+        // castling and double pawn pushes look at whether a piece has moved
+        switch (type) {
+            case PAWN:
+                piece->setMoved(row != ((c == 0) ? 6 : 1));
+                break;
+            case KING:
+                piece->setMoved(!fields.castling[c][0] && !fields.castling[c][1]);
+                if (c == 0) whiteKing = {row, col};
+                else blackKing = {row, col};
+                break;
+            case ROOK:
+                piece->setMoved(!(row == homeRow && ((col == 0 && fields.castling[c][0]) ||
+                                                     (col == 7 && fields.castling[c][1]))));
+                break;
+        }
+        board[row][col] = piece;
+    }
+    for (int c = 0; c < 2; c++) {
+        for (int type = PAWN; type <= KING; type++) {
+            while (spareCount[c][type]) {
+                delete spare[c][type][--spareCount[c][type]];
+            }
+        }
     }
 
-    // parse castling rights
-    for (char ch : castlingRights) {
-        if (ch == 'K') whiteCastlingRights.kingSide = true;
-        if (ch == 'Q') whiteCastlingRights.queenSide = true;
-        if (ch == 'k') blackCastlingRights.kingSide = true;
-        if (ch == 'q') blackCastlingRights.queenSide = true;
+    currentPlayer = fields.side;
+    whiteCastlingRights = {fields.castling[0][1], fields.castling[0][0]};
+    blackCastlingRights = {fields.castling[1][1], fields.castling[1][0]};
+    isWhiteInCheck = isBlackInCheck = false;
+    halfmoveClock = fields.halfmoveClock;
+    fullmoveNumber = fields.fullmoveNumber;
+    // en passant captures look at the previous move, so the double push is recreated
+    enPassantTarget = {fields.enPassantRow, fields.enPassantCol};
+    if (fields.enPassantRow >= 0) {
+        int direction = (fields.side == 'W') ? -1 : 1;
+        previousMove = {fields.enPassantRow + direction, fields.enPassantCol,
+                        fields.enPassantRow - direction, fields.enPassantCol};
+    } else {
+        previousMove = {-1, -1, -1, -1};
     }
+    refreshAccumulator();
+}
 
-    // parse en passant target square
-    if (enPassantSquare != "-") {
-        int file = enPassantSquare[0] - 'a';
-        int rank = 8 - (enPassantSquare[1] - '0');
-        enPassantTarget = {rank, file};
+std::string Board::toFEN() const {
+    // longest FEN: 64 pieces plus separators, all fields and two 6 digit counters
+    char text[128];
+    int length = 0;
+    for (int row = 0; row < 8; row++) {
+        int empty = 0;
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board[row][col];
+            if (!piece) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                text[length++] = '0' + empty;
+                empty = 0;
+            }
+            char letter = pieceLetters[piece->getPieceType()];
+            text[length++] = (piece->getColor() == 'W') ? letter : std::tolower(letter);
+        }
+        if (empty) {
+            text[length++] = '0' + empty;
+        }
+        text[length++] = (row < 7) ? '/' : ' ';
+    }
+    text[length++] = (currentPlayer == 'W') ? 'w' : 'b';
+    text[length++] = ' ';
+    int castlingStart = length;
+    if (hasCastlingRight('W', true)) text[length++] = 'K';
+    if (hasCastlingRight('W', false)) text[length++] = 'Q';
+    if (hasCastlingRight('B', true)) text[length++] = 'k';
+    if (hasCastlingRight('B', false)) text[length++] = 'q';
+    if (length == castlingStart) {
+        text[length++] = '-';
+    }
+    text[length++] = ' ';
+    // the square behind a pawn that just advanced two squares
+    int enPassantFile = getEnPassantFile();
+    if (enPassantFile >= 0) {
+        text[length++] = 'a' + enPassantFile;
+        text[length++] = (currentPlayer == 'W') ? '6' : '3';
     } else {
-        enPassantTarget = {-1, -1};
+        text[length++] = '-';
+    }
+    length += std::snprintf(text + length, sizeof(text) - length, " %d %d", halfmoveClock, fullmoveNumber);
+    return std::string(text, length);
+}
+
+char Board::getSideToMove() const {
+    return currentPlayer;
+}
+
+int Board::getEnPassantFile() const {
+    auto [fromRow, fromCol, toRow, toCol] = previousMove;
+    Piece* moved = (toRow >= 0) ? board[toRow][toCol] : nullptr;
+    if (moved && moved->getPieceType() == PAWN && std::abs(toRow - fromRow) == 2 && fromCol == toCol) {
+        return toCol;
     }
-    // not needed for now
-    halfmoveClock = stoi(halfmoveClock);
-    fullmoveNumber = stoi(fullmoveNumber);
+    return -1;
+}
+
+int Board::getHalfmoveClock() const {
+    return halfmoveClock;
+}
+
+int Board::getFullmoveNumber() const {
+    return fullmoveNumber;
 }
 
 void Board::display() const {
@@ -222,7 +751,9 @@ bool Board::isLegalMove(int startX, int startY, int endX, int endY, bool flag) {
     Piece* capturedPiece = board[endX][endY];
     Piece* enPassantCapturedPawn = nullptr;
 
-    // castling logic, recursively calls thrice
+    // castling logic: not out of check, then through and onto unattacked
+    // squares. Moving the king onto its own square would empty it and hide
+    // pawn checks, so the first test reads the bitboards.
     if (!flag && movingPiece->getType() == "King") {
         King* kingPiece = static_cast<King*>(movingPiece);
         // if both king and rook have not moved
@@ -233,14 +764,14 @@ bool Board::isLegalMove(int startX, int startY, int endX, int endY, bool flag) {
             if (dx == 0 && abs(dy) == 2) {
                 if (dy > 0) {
                     // king side castle, need to check 2 squares
-                    return isLegalMove(startX, startY, startX, startY, true) &&
+                    return !inCheck(movingPiece->getColor()) &&
                         board[startX][startY+1] == nullptr &&
                         board[startX][startY+2] == nullptr &&
                         isLegalMove(startX, startY, endX, startY + 1, true) &&
                         isLegalMove(startX, startY, endX, endY, true);
                 } else {
                     // queen side castle, need to check 3 squares
-                    return isLegalMove(startX, startY, startX, startY, true) &&
+                    return !inCheck(movingPiece->getColor()) &&
                         board[startX][startY-1] == nullptr &&
                         board[startX][startY-2] == nullptr &&
                         board[startX][startY-3] == nullptr &&
@@ -258,6 +789,9 @@ bool Board::isLegalMove(int startX, int startY, int endX, int endY, bool flag) {
         abs(get<2>(previousMove) - get<0>(previousMove)) == 2 &&
         abs(startY - get<1>(previousMove)) == 1 &&
         startX == get<2>(previousMove) &&
+        // only a pawn that just advanced two squares can be taken en passant
+        board[get<2>(previousMove)][get<3>(previousMove)] &&
+        board[get<2>(previousMove)][get<3>(previousMove)]->getPieceType() == PAWN &&
         endX == get<2>(previousMove) + 
             ((board[get<2>(previousMove)][get<3>(previousMove)]->getColor() == 'B') ? -1 : 1) &&
         endY == get<3>(previousMove)) {
@@ -341,7 +875,7 @@ bool Board::isLegalMove(int startX, int startY, int endX, int endY, bool flag) {
 }
 
 
-bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPlayer) {
+bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPlayer, int promotion) {
     // if (board[startX][startY]) {
     //     std::cout << "Start position: " << typeid(*board[startX][startY]).name() << std::endl;
     //     std::cout << board[startX][startY]->getType() << std::endl;
@@ -377,6 +911,8 @@ bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPl
         // std::cout << "Not a legal move!" << std::endl;
         return false;
     }
+    // the fifty move rule counts moves without a capture or pawn move
+    bool resetsClock = board[endX][endY] != nullptr || board[startX][startY]->getPieceType() == PAWN;
     // check if it was castle, then update rook as well
     if (board[startX][startY]->getType() == "King") {
         int dx = endX - startX;
@@ -387,12 +923,10 @@ bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPl
             auto [rookX, rookY] = king->getRookPosition(endX, endY, board);
             // kingside castle
             if (dy > 0) {
-                board[rookX][rookY-2] = board[rookX][rookY];
-                board[rookX][rookY] = nullptr;
+                putPiece(rookX, rookY-2, takePiece(rookX, rookY));
             // queenside castle
             } else {
-                board[rookX][rookY+3] = board[rookX][rookY];
-                board[rookX][rookY] = nullptr;
+                putPiece(rookX, rookY+3, takePiece(rookX, rookY));
             }
         }
     }
@@ -405,23 +939,21 @@ bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPl
             blackKing = std::make_tuple(endX, endY);
         }
     }
-    delete board[endX][endY];
+    delete takePiece(endX, endY);
     auto type = board[startX][startY]->getType();
     // promotion for pawn on 0th, 7th rank
-    if (type == "Pawn" && endX == 0 && currentPlayer == 'W') {
-        delete board[startX][startY];
-        board[startX][startY] = nullptr;
-        board[endX][endY] = new Queen('W');
-    } else if (type == "Pawn" && endX == 7 && currentPlayer == 'B') {
-        delete board[startX][startY];
-        board[startX][startY] = nullptr;
-        board[endX][endY] = new Queen('B');
+    if (type == "Pawn" && ((endX == 0 && currentPlayer == 'W') || (endX == 7 && currentPlayer == 'B'))) {
+        delete takePiece(startX, startY);
+        putPiece(endX, endY, createPiece(promotion, currentPlayer));
     // enpassant, need to remove the pawn being enpassanted
     } else if (type == "Pawn" &&
         get<1>(previousMove) == get<3>(previousMove) &&
         abs(get<2>(previousMove) - get<0>(previousMove)) == 2 &&
         abs(startY - get<1>(previousMove)) == 1 &&
         startX == get<2>(previousMove) &&
+        // only a pawn that just advanced two squares can be taken en passant
+        board[get<2>(previousMove)][get<3>(previousMove)] &&
+        board[get<2>(previousMove)][get<3>(previousMove)]->getPieceType() == PAWN &&
         endX == get<2>(previousMove) + 
             ((board[get<2>(previousMove)][get<3>(previousMove)]->getColor() == 'B') ? -1 : 1) &&
         endY == get<3>(previousMove)) {
@@ -431,17 +963,14 @@ bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPl
         int capturedPawnY = get<3>(previousMove);
 
         // delete the en passant captured pawn
-        delete board[capturedPawnX][capturedPawnY];
-        board[capturedPawnX][capturedPawnY] = nullptr;
+        delete takePiece(capturedPawnX, capturedPawnY);
 
         // move the current pawn to its destination
-        board[endX][endY] = board[startX][startY];
+        putPiece(endX, endY, takePiece(startX, startY));
         board[endX][endY]->makeMove();
-        board[startX][startY] = nullptr;
     } else {
-        board[endX][endY] = board[startX][startY];
+        putPiece(endX, endY, takePiece(startX, startY));
         board[endX][endY]->makeMove();
-        board[startX][startY] = nullptr;
     }
     // if (board[startX][startY]) {
     //     std::cout << "Start position: " << typeid(*board[startX][startY]).name() << std::endl;
@@ -452,8 +981,12 @@ bool Board::movePiece(int startX, int startY, int endX, int endY, char currentPl
     //     std::cout << board[endX][endY]->getType() << std::endl;
     // }
     previousMove = {startX, startY, endX, endY};
-    // show a ascii version of the board on the terminal
-    display();
+    halfmoveClock = resetsClock ? 0 : halfmoveClock + 1;
+    if (currentPlayer == 'B') {
+        fullmoveNumber++;
+    }
+    // the parameter shadows the member
+    this->currentPlayer = (currentPlayer == 'W') ? 'B' : 'W';
     return true;
 }
 
@@ -489,48 +1022,64 @@ std::vector<std::pair<int, int>> Board::getLegalMoves(int startX, int startY, ch
     return legalMoves;
 }
 
-// backtracking performance testing for move path enumeratin
+bool Board::hasCastlingRight(char color, bool kingSide) const {
+    int row = (color == 'W') ? 7 : 0;
+    Piece* king = board[row][4];
+    Piece* rook = board[row][kingSide ? 7 : 0];
+    if (!king || king->getColor() != color || king->getPieceType() != KING ||
+        !rook || rook->getColor() != color) {
+        return false;
+    }
+    return static_cast<King*>(king)->checkPseudoCastle(row, kingSide ? 6 : 2, board);
+}
+
+bool Board::inCheck(char color) const {
+    int us = colorIndex(color), them = us ^ 1;
+    Bitboard occupied = colorBitboards[0] | colorBitboards[1];
+    int kingSquare = lsb(pieceBitboards[us][KING]);
+    const Bitboard (&attackers)[6] = pieceBitboards[them];
+    return (attackTables.pawn[us][kingSquare] & attackers[PAWN]) ||
+        (attackTables.knight[kingSquare] & attackers[KNIGHT]) ||
+        (attackTables.king[kingSquare] & attackers[KING]) ||
+        (bishopAttacks(kingSquare, occupied) & (attackers[BISHOP] | attackers[QUEEN])) ||
+        (rookAttacks(kingSquare, occupied) & (attackers[ROOK] | attackers[QUEEN]));
+}
+
+// counts the leaf positions depth moves ahead, each promotion piece being
+// a move of its own. Moves are made with movePiece on a copy so castling,
+// en passant and the bitboards are handled as in play.
 long long Board::perft(int depth, char currentPlayer, long long& captureCount) {
     // base case: one position at depth 0
     if (depth == 0) {
         return 1;
     }
 
+    static const int promotions[] = {QUEEN, ROOK, BISHOP, KNIGHT};
     long long nodes = 0;
+    char opponent = currentPlayer == 'W' ? 'B' : 'W';
 
     // generate all legal moves for the current player
     for (int i = 0; i < 8; ++i) {
         for (int j = 0; j < 8; ++j) {
             Piece* piece = getPieceAt(i, j);
             if (piece && piece->getColor() == currentPlayer) {
+                bool isPawn = piece->getPieceType() == PAWN;
                 std::vector<std::pair<int, int>> legalMoves = getLegalMoves(i, j, currentPlayer);
                 for (const auto& move : legalMoves) {
-                    // make the move
-                    Piece* capturedPiece = board[move.first][move.second];
-                    bool isCapture = (capturedPiece != nullptr);
-                    board[move.first][move.second] = board[i][j];
-                    board[i][j] = nullptr;
-
-                    // update the position if king moves
-                    if (board[move.first][move.second]->getType() == "King") {
-                        if (currentPlayer == 'W') whiteKing = {move.first, move.second};
-                        else blackKing = {move.first, move.second};
-                    }
-
-                    // increment capture count if this move is a capture
-                    if (isCapture) {
-                        captureCount++;
-                    }
-
-                    // recurse to the next depth
-                    nodes += perft(depth - 1, currentPlayer == 'W' ? 'B' : 'W', captureCount);
-
-                    // undo the move (backtrack)
-                    board[i][j] = board[move.first][move.second];
-                    board[move.first][move.second] = capturedPiece;
-                    if (board[i][j]->getType() == "King") {
-                        if (currentPlayer == 'W') whiteKing = {i, j};
-                        else blackKing = {i, j};
+                    // a pawn changing file onto an empty square takes en passant
+                    bool isCapture = board[move.first][move.second] != nullptr || (isPawn && move.second != j);
+                    bool isPromotion = isPawn && (move.first == 0 || move.first == 7);
+                    for (int p = 0; p < (isPromotion ? 4 : 1); p++) {
+                        // the last move is counted without making it, and so
+                        // are captures, like published perft tables
+                        if (depth == 1) {
+                            captureCount += isCapture;
+                            nodes++;
+                            continue;
+                        }
+                        Board next(*this);
+                        next.movePiece(i, j, move.first, move.second, currentPlayer, promotions[p]);
+                        nodes += next.perft(depth - 1, opponent, captureCount);
                     }
                 }
             }
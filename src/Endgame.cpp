@@ -0,0 +1,152 @@
+#include "Endgame.h"
+#include <algorithm>
+#include <cstdlib>
+
+static int distance(int a, int b) {
+    return std::max(std::abs(a / 8 - b / 8), std::abs(a % 8 - b % 8));
+}
+
+// bonus for driving a king towards the edge, 0 in the centre
+static int pushToEdge(int square) {
+    int row = square / 8;
+    int col = square % 8;
+    return 20 * (6 - std::min(row, 7 - row) - std::min(col, 7 - col));
+}
+
+// bonus for keeping two kings close
+static int pushClose(int a, int b) {
+    return 20 * (7 - distance(a, b));
+}
+
+static int sideSign(int strongSide) {
+    return (strongSide == 0) ? 1 : -1;
+}
+
+// insufficient material, neither side can force mate
+static int evaluateDraw(const Board&, int) {
+    return 0;
+}
+
+// KQK, KRK: drive the lone king to the edge and bring the own king close
+static int evaluateKXK(const Board& board, int strongSide) {
+    int strongKing = lsb(board.pieceBitboards[strongSide][KING]);
+    int weakKing = lsb(board.pieceBitboards[strongSide ^ 1][KING]);
+    int bonus = KNOWN_WIN + pushToEdge(weakKing) + pushClose(strongKing, weakKing);
+    return sideSign(strongSide) * bonus + egValue(board.psqScore);
+}
+
+// KBNK: mate is only possible in a corner of the bishop's colour
+static int evaluateKBNK(const Board& board, int strongSide) {
+    int strongKing = lsb(board.pieceBitboards[strongSide][KING]);
+    int weakKing = lsb(board.pieceBitboards[strongSide ^ 1][KING]);
+    int bishop = lsb(board.pieceBitboards[strongSide][BISHOP]);
+    // a1 (row 7, col 0) is a dark square
+    bool darkBishop = (bishop / 8 + bishop % 8) % 2 == 1;
+    int cornerDistance = darkBishop ? std::min(distance(weakKing, 56), distance(weakKing, 7))
+                                    : std::min(distance(weakKing, 0), distance(weakKing, 63));
+    int bonus = KNOWN_WIN + pushToEdge(weakKing) + 40 * (7 - cornerDistance) + pushClose(strongKing, weakKing);
+    return sideSign(strongSide) * bonus + egValue(board.psqScore);
+}
+
+// KPK by rule of thumb: won when the lone king cannot catch the pawn even
+// with the move, drawn when it blocks a rook pawn, likely drawn when it
+// stands in front of the pawn, otherwise a pawn up
+static int evaluateKPK(const Board& board, int strongSide) {
+    // squares seen from the strong side, its pawn promotes on row 0
+    auto relative = [strongSide](int square) {
+        return (strongSide == 0) ? square : (7 - square / 8) * 8 + square % 8;
+    };
+    int pawn = relative(lsb(board.pieceBitboards[strongSide][PAWN]));
+    int strongKing = relative(lsb(board.pieceBitboards[strongSide][KING]));
+    int weakKing = relative(lsb(board.pieceBitboards[strongSide ^ 1][KING]));
+    int pawnRow = pawn / 8;
+    int pawnCol = pawn % 8;
+    // relative() turns the board so the pawn always moves like a white one,
+    // toward row 0: it promotes on rank 8 of its file, square 0 * 8 + pawnCol
+    int queeningSquare = pawnCol;
+    // the double step saves a move from the starting row
+    int pawnMoves = (pawnRow == 6) ? 5 : pawnRow;
+    bool strongKingInFront = strongKing % 8 == pawnCol && strongKing / 8 < pawnRow;
+    bool weakKingInFront = weakKing % 8 == pawnCol && weakKing / 8 < pawnRow;
+    int sign = sideSign(strongSide);
+
+    // rule of the square, the lone king is outside it even with the move
+    if (!strongKingInFront && distance(weakKing, queeningSquare) > pawnMoves + 1) {
+        return sign * (KNOWN_WIN + 20 * (7 - pawnRow)) + egValue(board.psqScore);
+    }
+    if (weakKingInFront && (pawnCol == 0 || pawnCol == 7)) {
+        return 0;
+    }
+    if (weakKingInFront && !strongKingInFront) {
+        return sign * 10;
+    }
+    return egValue(board.psqScore) + sign * 5 * (distance(weakKing, pawn) - distance(strongKing, pawn));
+}
+
+int knownWinScore(const Board& board, int strongSide) {
+    Bitboard pawns = board.pieceBitboards[strongSide][PAWN];
+    if (!pawns) {
+        return evaluateKXK(board, strongSide);
+    }
+    // rows still to go before promotion
+    int pawnRow = (strongSide == 0) ? lsb(pawns) / 8 : 7 - lsb(pawns) / 8;
+    return sideSign(strongSide) * (KNOWN_WIN + 20 * (7 - pawnRow)) + egValue(board.psqScore);
+}
+
+struct EndgameDefinition {
+    const char* code;
+    EndgameFunction function;
+};
+
+// signatures written with white as the strong side, the table below adds
+// the mirrored signature for black
+static constexpr EndgameDefinition endgameDefinitions[] = {
+    {"KK", evaluateDraw},
+    {"KNK", evaluateDraw},
+    {"KBK", evaluateDraw},
+    {"KNNK", evaluateDraw},
+    {"KQK", evaluateKXK},
+    {"KRK", evaluateKXK},
+    {"KBNK", evaluateKBNK},
+    {"KPK", evaluateKPK},
+};
+
+#define ENDGAME_COUNT (sizeof(endgameDefinitions) / sizeof(endgameDefinitions[0]))
+
+struct EndgameTable {
+    EndgameEntry entries[2 * ENDGAME_COUNT];
+};
+
+static constexpr EndgameTable buildEndgameTable() {
+    EndgameTable table{};
+    for (size_t i = 0; i < ENDGAME_COUNT; i++) {
+        MaterialKey key = materialKeyOf(endgameDefinitions[i].code);
+        table.entries[2 * i] = {key, endgameDefinitions[i].function, 0};
+        table.entries[2 * i + 1] = {mirrorMaterialKey(key), endgameDefinitions[i].function, 1};
+    }
+    return table;
+}
+
+static constexpr EndgameTable endgameTable = buildEndgameTable();
+
+// no signature above has more than this many pieces, kings included
+#define ENDGAME_MAX_PIECES 4
+
+const EndgameEntry* probeEndgame(const Board& board) {
+    if (popcount(board.colorBitboards[0] | board.colorBitboards[1]) > ENDGAME_MAX_PIECES) {
+        return nullptr;
+    }
+    for (const EndgameEntry& entry : endgameTable.entries) {
+        if (entry.key == board.materialKey) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool isDeadDraw(MaterialKey key) {
+    constexpr MaterialKey knight = materialKeyOf("KNK");
+    constexpr MaterialKey bishop = materialKeyOf("KBK");
+    return key == 0 || key == knight || key == bishop ||
+        key == mirrorMaterialKey(knight) || key == mirrorMaterialKey(bishop);
+}
@@ -1,34 +1,128 @@
+#include <algorithm>
 #include <utility>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <mutex>
 #include <thread>
-#include <unordered_set>
 #include "Engine.h"
 #include "Piece.h"
 #include "King.h"
 #include "PieceValue.h"
+#include "PawnHash.h"
+#include "Endgame.h"
+#include "Bitbase.h"
+#include "San.h"
+#include "Trace.h"
 
+// plies searched by getBestMove()
 #define DEPTH 3
-#define ENDGAME_THRESHOLD 14
+// nodes a thread searches between looking at the clock and node limit
+#define NODE_CHECK_INTERVAL 1024
+// milliseconds kept back per move for the protocol and the operating system
+#define MOVE_OVERHEAD 20
+// moves assumed left in the game when the clock does not say
+#define DEFAULT_MOVES_TO_GO 30
+
+// bonus per attacked square not occupied by an own piece, indexed by PieceType
+static const Score mobilityBonus[6] = {0, makeScore(4, 4), makeScore(5, 5), makeScore(2, 4), makeScore(1, 2), 0};
+// bonus per square of the enemy king zone attacked by a piece of each type
+static const Score kingZoneAttack[6] = {makeScore(5, 0), makeScore(10, 0), makeScore(10, 0), makeScore(15, 0), makeScore(25, 0), 0};
+static const Score rookOpenFile = makeScore(20, 10);
+static const Score rookSemiOpenFile = makeScore(10, 5);
+// knight or bishop on the enemy half, defended by a pawn and out of reach of enemy pawns
+static const Score minorOutpost = makeScore(15, 10);
+
+// the engine's pawn structure cache for the calling search thread; nullptr
+// outside a search, where evaluate() falls back to the thread's own
+static thread_local PawnHashTable* pawnHashTable = nullptr;
+
+static PawnHashTable& threadPawnTable() {
+    if (pawnHashTable) {
+        return *pawnHashTable;
+    }
+    // only built in threads that evaluate outside a search
+    static thread_local PawnHashTable ownTable;
+    return ownTable;
+}
+// nodes searched since the last flush into searchNodes
+static thread_local uint64_t pendingNodes = 0;
+
+// search statistics cost a clock read per move generation and evaluation,
+// so they are only counted in builds made with SEARCH_STATS
+#ifdef SEARCH_STATS
+#define STATS(statement) statement
+// this thread's counters, added to the engine's when the thread finishes
+static thread_local SearchStats threadStats;
+
+static uint64_t statsClock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#else
+#define STATS(statement)
+#endif
 
-Engine::Engine(Board& board, char color) : board(board), color(color) {}
+Engine::Engine(Board& board, char color) : board(board), color(color),
+    threadCount(std::max((int)std::thread::hardware_concurrency(), 1)) {}
 
 // finds the best move
 std::pair<std::pair<int, int>, std::pair<int, int>> Engine::getBestMove(char currentPlayer) {
-    // initial best value
-    int bestValue = (currentPlayer == 'W') ? -1000000 : 1000000;
-    // move to return
+    std::pair<std::pair<int, int>, std::pair<int, int>> bookMove;
+    if (probeBook(currentPlayer, bookMove)) {
+        return bookMove;
+    }
+    // the network may have been loaded after the board was set up
+    if (useNnue) {
+        board.refreshAccumulator();
+    }
+    // fixed depth, no limits
+    stopRequested = false;
+    pondering = false;
+    timeLimit = 0;
+    nodeLimit = 0;
     std::pair<std::pair<int, int>, std::pair<int, int>> bestMove;
+    int bestValue;
+    TraceSpan span("getBestMove", DEPTH);
+    searchRoot(board, currentPlayer, DEPTH, bestMove, bestValue);
+    return bestMove;
+}
+
+bool Engine::probeBook(char currentPlayer, std::pair<std::pair<int, int>, std::pair<int, int>>& move) {
+    // book moves need no search, but are checked against the legal moves
+    BookMove bookMove;
+    if (book && book->pickMove(board, currentPlayer, bookBestOnly, bookMove)) {
+        auto [fromX, fromY] = bookMove.from;
+        Piece* piece = board.board[fromX][fromY];
+        if (piece && piece->getColor() == currentPlayer) {
+            for (const auto& to : board.getLegalMoves(fromX, fromY, currentPlayer)) {
+                if (to == bookMove.to) {
+                    move = {bookMove.from, bookMove.to};
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool Engine::searchRoot(Board& rootBoard, char currentPlayer, int depth,
+                        std::pair<std::pair<int, int>, std::pair<int, int>>& bestMove, int& bestValue) {
+    rootDepth = depth;
+    // initial best value, worse than being mated so a move is always picked
+    const int worstValue = (currentPlayer == 'W') ? -1000001 : 1000001;
+    bestValue = worstValue;
+    bool found = false;
     std::vector<std::tuple<int, int, std::pair<int, int>>> moves;
 
     std::mutex bestMoveMutex;
     // iterate through all possible moves
     for (int i = 0; i < 8; i++) {
         for (int j = 0; j < 8; j++) {
-            Piece* piece = board.board[i][j];
+            Piece* piece = rootBoard.board[i][j];
             if (piece && piece->getColor() == currentPlayer) {
                 // Generate legal moves for the piece
-                auto legalMoves = board.getLegalMoves(i, j, currentPlayer);
+                auto legalMoves = rootBoard.getLegalMoves(i, j, currentPlayer);
                 for (const auto& move : legalMoves) {
                     moves.emplace_back(i, j, move);
                 }
@@ -37,198 +131,433 @@ std::pair<std::pair<int, int>, std::pair<int, int>> Engine::getBestMove(char cur
     }
 
     // evaluate a subset of moves
-    auto evaluateMoves = [&](const std::vector<std::tuple<int, int, std::pair<int, int>>>& movesSubset, Board threadLocalBoard) {
-        int localBestValue = bestValue;
+    auto evaluateMoves = [&](const std::vector<std::tuple<int, int, std::pair<int, int>>>& movesSubset, Board threadLocalBoard,
+                             PawnHashTable* pawnTable) {
+        pawnHashTable = pawnTable;
+        int localBestValue = worstValue;
+        bool localFound = false;
         std::pair<std::pair<int, int>, std::pair<int, int>> localBestMove;
+        if (Trace::isEnabled()) {
+            Trace::setThreadName("search thread");
+        }
+        TraceSpan threadSpan("search moves", (int64_t)movesSubset.size());
 
         for (const auto& [startX, startY, end] : movesSubset) {
+            if (treeRecorder) {
+                treeRecorder->beginRootMove(depth, startX * 8 + startY, end.first * 8 + end.second);
+            }
+            TraceSpan moveSpan("root move", depth, Trace::isEnabled() ?
+                coordinateMove(threadLocalBoard, startX, startY, end.first, end.second).c_str() : nullptr);
             int eval;
-            if (moveAndUnmove(startX, startY, end.first, end.second, eval, DEPTH, currentPlayer, threadLocalBoard)) {
+            if (moveAndUnmove(startX, startY, end.first, end.second, eval, depth, currentPlayer, threadLocalBoard)) {
                 if ((currentPlayer == 'W' && eval > localBestValue) ||
                     (currentPlayer == 'B' && eval < localBestValue)) {
                     localBestValue = eval;
                     localBestMove = {{startX, startY}, end};
+                    localFound = true;
                 }
             }
         }
 
+        searchNodes += pendingNodes;
+        pendingNodes = 0;
+
         std::lock_guard<std::mutex> lock(bestMoveMutex);
-        if ((currentPlayer == 'W' && localBestValue > bestValue) ||
-            (currentPlayer == 'B' && localBestValue < bestValue)) {
+        STATS(searchStats += threadStats; threadStats.clear());
+        if (localFound && (!found ||
+            (currentPlayer == 'W' && localBestValue > bestValue) ||
+            (currentPlayer == 'B' && localBestValue < bestValue))) {
             bestValue = localBestValue;
             bestMove = localBestMove;
+            found = true;
         }
     };
-    // divide the moves into chunks for each thread
-
-    // Goes from: (1 thread only)
-    // Spent 3.53503s
-    // Spent 6.25526s
-    // Spent 10.4587s
-
-    // to: (12 threads on my cpu)
-    // Spent 0.922531s
-    // Spent 1.29316s
-    // Spent 1.52756s
-    const int numThreads = std::thread::hardware_concurrency();
+    // divide the moves into chunks for each thread; "bench" measures the
+    // single threaded speed
+    const int numThreads = threadCount;
     std::vector<std::thread> threads;
     size_t chunkSize = std::max((moves.size() + numThreads - 1) / numThreads, size_t(1));
+    // the nth thread of every iteration gets the same table
+    size_t chunkCount = (moves.size() + chunkSize - 1) / chunkSize;
+    if (pawnTables.size() < chunkCount) {
+        pawnTables.resize(chunkCount);
+    }
 
     for (size_t i = 0; i < moves.size(); i += chunkSize) {
         std::vector<std::tuple<int, int, std::pair<int, int>>> movesSubset(
             moves.begin() + i,
             moves.begin() + std::min(i + chunkSize, moves.size())
         );
-        threads.emplace_back([&, movesSubset, threadLocalBoard = board]() {
-            evaluateMoves(movesSubset, threadLocalBoard);
+        PawnHashTable* pawnTable = &pawnTables[i / chunkSize];
+        threads.emplace_back([&, movesSubset, pawnTable, threadLocalBoard = rootBoard]() {
+            evaluateMoves(movesSubset, threadLocalBoard, pawnTable);
         });
     }
     // join all threads
+    TraceSpan waitSpan("wait for threads");
     for (auto& thread : threads) {
         thread.join();
     }
-    return bestMove;
+    return found;
 }
 
-int Engine::evaluate(Board& threadLocalBoard) const {
-    int whiteEval{};
-    int blackEval{};
-    int nonPawnMaterial{};
-    std::unordered_set<std::pair<int, int>, PairHash> whiteAttackedSquares;
-    std::unordered_set<std::pair<int, int>, PairHash> blackAttackedSquares;
-    
-    // find attacked squares
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            Piece* piece = threadLocalBoard.board[i][j];
-            if (piece) {
-                char pieceColor = piece->getColor();
-                auto legalMoves = threadLocalBoard.getLegalMoves(i, j, pieceColor);
-                for (const auto& move : legalMoves) {
-                    if (pieceColor == 'W') {
-                        whiteAttackedSquares.insert(move);
-                    } else {
-                        blackAttackedSquares.insert(move);
-                    }
-                }
-            }
+// milliseconds to spend on a move, 0 for no limit
+static int64_t allotTime(const SearchLimits& limits, int side) {
+    if (limits.infinite) {
+        return 0;
+    }
+    if (limits.moveTime > 0) {
+        return std::max(limits.moveTime - MOVE_OVERHEAD, int64_t(1));
+    }
+    if (limits.time[side] <= 0) {
+        return 0;
+    }
+    int movesToGo = (limits.movesToGo > 0) ? limits.movesToGo : DEFAULT_MOVES_TO_GO;
+    int64_t budget = limits.time[side] / movesToGo + limits.increment[side] * 3 / 4;
+    // never risk more than half of the clock on one move
+    budget = std::min(budget, limits.time[side] / 2);
+    return std::max(budget - MOVE_OVERHEAD, int64_t(1));
+}
+
+static int64_t clockMilliseconds() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SearchInfo Engine::search(char currentPlayer, const SearchLimits& limits,
+                          const std::function<void(const SearchInfo&)>& onIteration) {
+    if (useNnue) {
+        board.refreshAccumulator();
+    }
+    stopRequested = false;
+    pondering = limits.ponder;
+    searchNodes = 0;
+    searchStats.clear();
+    STATS(searchStats.enabled = true);
+    searchStart = clockMilliseconds();
+    clockStart = searchStart;
+    nodeLimit = limits.nodes;
+    timeLimit = allotTime(limits, colorIndex(currentPlayer));
+    // with a clock, a new depth is not started after half the time is gone,
+    // since it would take several times longer than the last one
+    bool clockLimited = limits.moveTime <= 0 && timeLimit > 0;
+    int maxDepth = (limits.depth > 0) ? std::min(limits.depth, MAX_SEARCH_DEPTH) : MAX_SEARCH_DEPTH;
+
+    SearchInfo info;
+    TraceSpan searchSpan("search");
+    if (probeBook(currentPlayer, info.bestMove)) {
+        return info;
+    }
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        TraceSpan iterationSpan("iteration", depth);
+        std::pair<std::pair<int, int>, std::pair<int, int>> move;
+        int value;
+        STATS(uint64_t iterationStart = searchNodes);
+        if (!searchRoot(board, currentPlayer, depth, move, value)) {
+            break;
+        }
+        STATS(searchStats.iterationNodes[std::min(depth, STATS_MAX_DEPTH - 1)] = searchNodes - iterationStart);
+        // an interrupted depth is incomplete, keep the last full one; depth 1
+        // only evaluates leaves, which ignore the stop, so it always completes
+        if (stopRequested && depth > 1) {
+            break;
+        }
+        info.depth = depth;
+        info.score = value;
+        info.bestMove = move;
+        info.nodes = searchNodes;
+        info.time = elapsed();
+        if (onIteration) {
+            onIteration(info);
+        }
+        if (stopRequested || (clockLimited && !pondering && clockMilliseconds() - clockStart >= timeLimit / 2)) {
+            break;
         }
     }
 
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (threadLocalBoard.board[i][j]) {
-                Piece* piece = threadLocalBoard.board[i][j];
-
-                // check if king under attack
-                // if (piece->getType() == "King") {
-                //     if (piece->getColor() == 'W') {
-                //         auto [kingX, kingY] = threadLocalBoard.whiteKing;
-                //         auto legalMoves = threadLocalBoard.getLegalMoves(i, j, 'W');
-                //         if (!legalMoves.empty()) {
-                //             if (piece->isValidPieceMove(i, j, kingX, kingY, threadLocalBoard.board, threadLocalBoard.previousMove)) {
-                //                 return std::numeric_limits<int>::max(); 
-                //             }
-                //         }
-                //     } else {
-                //         auto [kingX, kingY] = threadLocalBoard.blackKing;
-                //         auto legalMoves = threadLocalBoard.getLegalMoves(i, j, 'B');
-                //         if (!legalMoves.empty()) {
-                //            if (piece->isValidPieceMove(i, j, kingX, kingY, threadLocalBoard.board, threadLocalBoard.previousMove)) {
-                //                 return std::numeric_limits<int>::min(); 
-                //             } 
-                //         }
-                //     }
-                // }
-
-                int row = (piece->getColor() == 'W') ? i : 7 - i;
-                int col = j;
-                
-                int pieceValue = pieceValues.find(piece->getType())->second;
-
-                // add positional value from piece-square table
-                if (piece->getType() == "Pawn") {
-                    pieceValue += pawnTable[row][col];
-
-                    // white pawn on 7th rank
-                    if (piece->getColor() == 'W') {
-                        pieceValue += 500 * (row - 6) / 6;
-                    // black pawn on 2nd rank
-                    } else if (piece->getColor() == 'B') {
-                        pieceValue += 500 * (6 - row) / 6;
-                    }
-                } else if (piece->getType() == "Knight") {
-                    pieceValue += knightTable[row][col];
-                } else if (piece->getType() == "Bishop") {
-                    pieceValue += bishopTable[row][col];
-                } else if (piece->getType() == "Rook") {
-                    pieceValue += rookTable[row][col];
-                } else if (piece->getType() == "Queen") {
-                    pieceValue += queenTable[row][col];
-                } else if (piece->getType() == "King") {
-                    if (nonPawnMaterial <= ENDGAME_THRESHOLD) {
-                        pieceValue += kingEndGameTable[row][col];
-                    } else {
-                        pieceValue += kingMiddleGameTable[row][col];
-                    }
-                }
+    if (info.bestMove.first.first >= 0) {
+        Board next = board;
+        auto [from, to] = info.bestMove;
+        char opponent = (currentPlayer == 'W') ? 'B' : 'W';
+        int value;
+        if (next.movePiece(from.first, from.second, to.first, to.second, currentPlayer) &&
+            !searchRoot(next, opponent, 1, info.ponderMove, value)) {
+            info.ponderMove = {{-1, -1}, {-1, -1}};
+        }
+    }
+    return info;
+}
 
-                // penalty for being on attacked squares
-                auto& opponentAttackedSquares = (piece->getColor() == 'W') ? blackAttackedSquares : whiteAttackedSquares;
-                if (opponentAttackedSquares.find({i, j}) != opponentAttackedSquares.end()) {
-                    // penalty based on piece value
-                    pieceValue -= pieceValues.find(piece->getType())->second / 2;
-                }
+void Engine::stop() {
+    stopRequested = true;
+}
 
-                // bonus for capturing opponent pieces
-                auto legalMoves = threadLocalBoard.getLegalMoves(i, j, piece->getColor());
-                for (const auto& move : legalMoves) {
-                    int targetX = move.first;
-                    int targetY = move.second;
-                    Piece* target = threadLocalBoard.board[targetX][targetY];
-                    if (target && target->getColor() != piece->getColor()) {
-                        int attackerValue = pieceValues.find(piece->getType())->second;
-                        int targetValue = pieceValues.find(target->getType())->second;
-
-                        // bonus for favourable captures
-                        if (targetValue >= attackerValue) {
-                            // Larger bonus for more favourable trades
-                            pieceValue += targetValue - attackerValue;
-                        }
-                    }
-                }
+void Engine::ponderHit() {
+    // the move was expected, the clock starts now
+    clockStart = clockMilliseconds();
+    pondering = false;
+}
 
-                if (piece->getColor() == 'W') {
-                    // std::cout<<"whiteEval += " << pieceValue << std::endl;
-                    whiteEval += pieceValue;
-                } else {
-                    // std::cout<<"blackEval += " << pieceValue << std::endl;
-                    blackEval += pieceValue;
+int64_t Engine::elapsed() const {
+    return clockMilliseconds() - searchStart;
+}
+
+void Engine::checkLimits() {
+    if ((nodeLimit && searchNodes >= nodeLimit) ||
+        (timeLimit && !pondering && clockMilliseconds() - clockStart >= timeLimit)) {
+        stopRequested = true;
+    }
+}
+
+int Engine::evaluate(Board& threadLocalBoard, int alpha, int beta) const {
+#ifdef EVAL_DEBUG
+    // cross-check the incremental state against a full rescan
+    if (!threadLocalBoard.verifyState()) {
+        std::abort();
+    }
+#endif
+    int eval;
+    STATS(threadStats.evalCalls++);
+    if (evalCache.probe(threadLocalBoard.hashKey, eval)) {
+        STATS(threadStats.evalCacheHits++);
+        return eval;
+    }
+    bool exact = true;
+    STATS(uint64_t evalStart = statsClock());
+    eval = staticEvaluation(threadLocalBoard, alpha, beta, exact);
+    STATS(threadStats.evalTime += statsClock() - evalStart);
+    // a lazy result is only a bound for this window, so it is not cached
+    if (exact) {
+        evalCache.store(threadLocalBoard.hashKey, eval);
+    }
+    return eval;
+}
+
+const SearchStats& Engine::getSearchStats() const {
+    return searchStats;
+}
+
+void Engine::setBook(const PolyglotBook* openingBook, bool bestOnly) {
+    book = openingBook;
+    bookBestOnly = bestOnly;
+}
+
+void Engine::setTreeRecorder(SearchTreeRecorder* recorder) {
+    treeRecorder = recorder;
+}
+
+void Engine::setThreads(int count) {
+    threadCount = std::max(count, 1);
+}
+
+void Engine::setHashSize(size_t megabytes) {
+    // largest power of two number of 8 byte entries that fits
+    size_t entries = 1;
+    while (entries * 2 * sizeof(uint64_t) <= megabytes * 1024 * 1024) {
+        entries *= 2;
+    }
+    evalCache.resize(entries);
+}
+
+void Engine::clearHash() {
+    evalCache.clear();
+}
+
+bool Engine::setUseNnue(bool enable) {
+    if (enable && !Nnue::isLoaded()) {
+        return false;
+    }
+    if (enable != useNnue) {
+        // cached scores came from the other evaluator
+        evalCache.clear();
+        useNnue = enable;
+    }
+    return true;
+}
+
+int Engine::staticEvaluation(Board& threadLocalBoard, int alpha, int beta, bool& exact) const {
+    // known endgames have their own scoring
+    if (const EndgameEntry* endgame = probeEndgame(threadLocalBoard)) {
+        return endgame->function(threadLocalBoard, endgame->strongSide);
+    }
+    if (useNnue) {
+        return Nnue::evaluate(threadLocalBoard.accumulator);
+    }
+    // material and piece-square tables, kept up to date by make/unmake
+    Score eval = threadLocalBoard.psqScore;
+    // pawn structure, recomputed only when the pawns change
+    STATS(threadStats.pawnHashHits += threadPawnTable().contains(threadLocalBoard));
+    const PawnEntry& pawns = threadPawnTable().probe(threadLocalBoard);
+    eval += pawns.score;
+
+    // lazy exit: return a bound that is still outside the window
+    STATS(threadStats.lazyEvalCalls++);
+    int lazyEval = taper(eval, threadLocalBoard.gamePhase);
+    if (lazyEval - LAZY_EVAL_MARGIN >= beta) {
+        STATS(threadStats.lazyExits++);
+        exact = false;
+        return lazyEval - LAZY_EVAL_MARGIN;
+    }
+    if (lazyEval + LAZY_EVAL_MARGIN <= alpha) {
+        STATS(threadStats.lazyExits++);
+        exact = false;
+        return lazyEval + LAZY_EVAL_MARGIN;
+    }
+
+    const Bitboard occupied = threadLocalBoard.colorBitboards[0] | threadLocalBoard.colorBitboards[1];
+    // squares attacked by each side, per piece type and in total
+    Bitboard attackedBy[2][6] = {};
+    Bitboard attackedByAll[2] = {};
+    Score sideScore[2] = {0, 0};
+
+    // build attack maps from pseudo-legal attack patterns, scoring mobility on the way
+    for (int c = 0; c < 2; c++) {
+        Bitboard own = threadLocalBoard.colorBitboards[c];
+        for (int type = PAWN; type <= KING; type++) {
+            Bitboard pieces = threadLocalBoard.pieceBitboards[c][type];
+            while (pieces) {
+                int square = popLsb(pieces);
+                Bitboard attacks = 0;
+                switch (type) {
+                    case PAWN: attacks = attackTables.pawn[c][square]; break;
+                    case KNIGHT: attacks = attackTables.knight[square]; break;
+                    case BISHOP: attacks = bishopAttacks(square, occupied); break;
+                    case ROOK: attacks = rookAttacks(square, occupied); break;
+                    case QUEEN: attacks = queenAttacks(square, occupied); break;
+                    case KING: attacks = attackTables.king[square]; break;
                 }
+                attackedBy[c][type] |= attacks;
+                sideScore[c] += mobilityBonus[type] * popcount(attacks & ~own);
+            }
+            attackedByAll[c] |= attackedBy[c][type];
+        }
+    }
 
-                // track non-pawn material for endgame determination
-                if (piece->getType() != "Pawn") {
-                    nonPawnMaterial += pieceValues.find(piece->getType())->second;
+    for (int c = 0; c < 2; c++) {
+        int them = c ^ 1;
+
+        // penalty for pieces attacked and not defended
+        Bitboard hanging = threadLocalBoard.colorBitboards[c] & attackedByAll[them] & ~attackedByAll[c];
+        for (int type = PAWN; type < KING; type++) {
+            int count = popcount(hanging & threadLocalBoard.pieceBitboards[c][type]);
+            sideScore[c] -= makeScore(pieceMiddleGameValues[type] / 2, pieceEndGameValues[type] / 2) * count;
+        }
+
+        // bonus for opponent pieces attacked by a piece worth no more than them,
+        // counting each target once against its cheapest attacker
+        for (int targetType = KNIGHT; targetType < KING; targetType++) {
+            Bitboard targets = threadLocalBoard.pieceBitboards[them][targetType];
+            for (int attackerType = PAWN; attackerType < KING && targets; attackerType++) {
+                if (pieceMiddleGameValues[attackerType] > pieceMiddleGameValues[targetType]) {
+                    continue;
                 }
+                Bitboard hit = targets & attackedBy[c][attackerType];
+                targets &= ~hit;
+                sideScore[c] += makeScore(pieceMiddleGameValues[targetType] - pieceMiddleGameValues[attackerType],
+                                          pieceEndGameValues[targetType] - pieceEndGameValues[attackerType]) * popcount(hit);
+            }
+        }
 
+        // rooks on files without own pawns
+        Bitboard rooks = threadLocalBoard.pieceBitboards[c][ROOK];
+        while (rooks) {
+            int col = popLsb(rooks) % 8;
+            if (pawns.openFiles & (1 << col)) {
+                sideScore[c] += rookOpenFile;
+            } else if (pawns.semiOpenFiles[c] & (1 << col)) {
+                sideScore[c] += rookSemiOpenFile;
+            }
+        }
+
+        // minor pieces on squares enemy pawns can never attack
+        Bitboard enemyHalf = (c == 0) ? 0x00000000FFFFFFFFULL : 0xFFFFFFFF00000000ULL;
+        Bitboard outposts = enemyHalf & attackedBy[c][PAWN] & ~pawns.pawnAttackSpans[them];
+        Bitboard minors = threadLocalBoard.pieceBitboards[c][KNIGHT] | threadLocalBoard.pieceBitboards[c][BISHOP];
+        sideScore[c] += minorOutpost * popcount(minors & outposts);
+
+        // bonus for attacking the squares around the opponent's king
+        Bitboard enemyKing = threadLocalBoard.pieceBitboards[them][KING];
+        if (enemyKing) {
+            int kingSquare = lsb(enemyKing);
+            Bitboard kingZone = attackTables.king[kingSquare] | enemyKing;
+            for (int type = PAWN; type < KING; type++) {
+                sideScore[c] += kingZoneAttack[type] * popcount(attackedBy[c][type] & kingZone);
             }
         }
     }
-    return whiteEval - blackEval;
+
+    eval += sideScore[0] - sideScore[1];
+    // held to the lazy margin, so the bounds the lazy exit returns are never
+    // wrong; a bigger swing, e.g. a queen attacked by a pawn, is a tactic
+    // the search resolves anyway
+    return std::clamp(taper(eval, threadLocalBoard.gamePhase),
+                      lazyEval - LAZY_EVAL_MARGIN, lazyEval + LAZY_EVAL_MARGIN);
 }
 
-int Engine::evaluatePosition(int depth, char currentPlayer, Board& threadLocalBoard) {
-    if (depth > 0) {
-        return minimax(depth - 1, (currentPlayer == 'W') ? 'B' : 'W', -1000000, 1000000, threadLocalBoard);
+int Engine::evaluatePosition(int depth, char currentPlayer, Board& threadLocalBoard, int alpha, int beta) {
+    if (++pendingNodes == NODE_CHECK_INTERVAL) {
+        searchNodes += pendingNodes;
+        pendingNodes = 0;
+        checkLimits();
     }
-    return evaluate(threadLocalBoard);
+    return minimax(depth - 1, (currentPlayer == 'W') ? 'B' : 'W', alpha, beta, threadLocalBoard);
+}
+
+int Engine::noMoveScore(const Board& threadLocalBoard, char currentPlayer, int depth) const {
+    if (!threadLocalBoard.inCheck(currentPlayer)) {
+        return 0;
+    }
+    // nearer mates score higher
+    int mated = -(MATE_SCORE - (rootDepth - depth));
+    return (currentPlayer == 'W') ? mated : -mated;
 }
 
 int Engine::minimax(int depth, char currentPlayer, int alpha, int beta, Board& threadLocalBoard) {
+    if (!treeRecorder) {
+        return searchNode(depth, currentPlayer, alpha, beta, threadLocalBoard, nullptr);
+    }
+    SearchTreeNode* record = treeRecorder->enter(threadLocalBoard, currentPlayer, depth, alpha, beta);
+    int value = searchNode(depth, currentPlayer, alpha, beta, threadLocalBoard, record);
+    if (record) {
+        treeRecorder->leave(record, value);
+    }
+    return value;
+}
+
+int Engine::searchNode(int depth, char currentPlayer, int alpha, int beta, Board& threadLocalBoard, SearchTreeNode* record) {
+    // nothing left to search when neither side can mate
+    if (isDeadDraw(threadLocalBoard.materialKey)) {
+        if (record) record->reason = TREE_DRAW;
+        return 0;
+    }
+    // exact result of three piece endings; wins are still searched so mates
+    // within the horizon are found, the bitbase scores the leaves
+    int strongSide;
+    BitbaseResult bitbaseResult = probeBitbase(threadLocalBoard, colorIndex(currentPlayer), strongSide);
+    if (bitbaseResult == BITBASE_DRAW) {
+        if (record) record->reason = TREE_DRAW;
+        return 0;
+    }
+    if (bitbaseResult == BITBASE_WIN && depth == 0) {
+        if (record) record->reason = TREE_BITBASE_WIN;
+        return knownWinScore(threadLocalBoard, strongSide);
+    }
     // base case: if depth is 0
     if (depth == 0) {
-        return evaluate(threadLocalBoard);
+        if (record) record->reason = TREE_LEAF;
+        return evaluate(threadLocalBoard, alpha, beta);
+    }
+    // the result is thrown away, unwind quickly; leaves are still evaluated
+    // so a one ply search always completes
+    if (stopRequested.load(std::memory_order_relaxed)) {
+        if (record) record->reason = TREE_STOPPED;
+        return 0;
     }
+    bool anyMove = false;
+    STATS(int statsDepth = std::min(depth, STATS_MAX_DEPTH - 1));
+    STATS(threadStats.nodes[statsDepth]++);
+    // legal moves searched so far, a cutoff by the first is well ordered
+    STATS(int movesSearched = 0);
     // maximizing player
     if (currentPlayer == 'W') {
         int maxEval = -1000000;
@@ -237,14 +566,21 @@ int Engine::minimax(int depth, char currentPlayer, int alpha, int beta, Board& t
                 Piece* piece = threadLocalBoard.board[startX][startY];
                 if (piece && piece->getColor() == 'W') {
                     // get legal moves for the piece
+                    STATS(uint64_t moveGenStart = statsClock());
                     std::vector<std::pair<int, int>> legalMoves = threadLocalBoard.getLegalMoves(startX, startY, 'W');
+                    STATS(threadStats.moveGenTime += statsClock() - moveGenStart);
                     for (const auto& move : legalMoves) {
                         int eval;
-                        if (moveAndUnmove(startX, startY, move.first, move.second, eval, depth, currentPlayer, threadLocalBoard)) {
+                        if (moveAndUnmove(startX, startY, move.first, move.second, eval, depth, currentPlayer, threadLocalBoard, false, alpha, beta)) {
+                            STATS(threadStats.moves[statsDepth]++; movesSearched++);
+                            if (record) record->movesSearched++;
+                            anyMove = true;
                             maxEval = std::max(maxEval, eval);
                             alpha = std::max(alpha, maxEval);
                             // alpha-beta pruning
                             if (beta <= alpha) {
+                                STATS(threadStats.betaCutoffs++; threadStats.firstMoveCutoffs += movesSearched == 1);
+                                if (record) record->reason = TREE_BETA_CUTOFF;
                                 return maxEval;
                             }
                         }
@@ -252,7 +588,7 @@ int Engine::minimax(int depth, char currentPlayer, int alpha, int beta, Board& t
                 }
             }
         }
-        return maxEval;
+        return anyMove ? maxEval : noMoveScore(threadLocalBoard, 'W', depth);
     } else {
         // minimizing player
         int minEval = 1000000;
@@ -261,14 +597,21 @@ int Engine::minimax(int depth, char currentPlayer, int alpha, int beta, Board& t
                 Piece* piece = threadLocalBoard.board[startX][startY];
                 if (piece && piece->getColor() == 'B') {
                     // get legal moves for the piece
+                    STATS(uint64_t moveGenStart = statsClock());
                     std::vector<std::pair<int, int>> legalMoves = threadLocalBoard.getLegalMoves(startX, startY, 'B');
+                    STATS(threadStats.moveGenTime += statsClock() - moveGenStart);
                     for (const auto& move : legalMoves) {
                         int eval;
-                        if (moveAndUnmove(startX, startY, move.first, move.second, eval, depth, currentPlayer, threadLocalBoard)) {
+                        if (moveAndUnmove(startX, startY, move.first, move.second, eval, depth, currentPlayer, threadLocalBoard, false, alpha, beta)) {
+                            STATS(threadStats.moves[statsDepth]++; movesSearched++);
+                            if (record) record->movesSearched++;
+                            anyMove = true;
                             minEval = std::min(minEval, eval);
                             beta = std::min(beta, minEval);
                             // alpha-beta pruning
                             if (beta <= alpha) {
+                                STATS(threadStats.betaCutoffs++; threadStats.firstMoveCutoffs += movesSearched == 1);
+                                if (record) record->reason = TREE_BETA_CUTOFF;
                                 return minEval;
                             }
                         }
@@ -276,17 +619,19 @@ int Engine::minimax(int depth, char currentPlayer, int alpha, int beta, Board& t
                 }
             }
         }
-        return minEval;
+        return anyMove ? minEval : noMoveScore(threadLocalBoard, 'B', depth);
     }
 }
 
-bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval, int depth, char currentPlayer, Board& threadLocalBoard, bool flag) {
+bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval, int depth, char currentPlayer, Board& threadLocalBoard, bool flag, int alpha, int beta) {
     // backup the current state
     Piece* movingPiece = threadLocalBoard.board[startX][startY];
     Piece* capturedPiece = threadLocalBoard.board[endX][endY];
     Piece* enPassantCapturedPawn = nullptr;
+    // en passant in the replies looks at the move made here
+    auto lastMove = threadLocalBoard.previousMove;
 
-    // castling logic, recursively calls thrice
+    // castling logic, as in Board::isLegalMove
     if (!flag && movingPiece->getType() == "King") {
         King* kingPiece = static_cast<King*>(movingPiece);
         // if both king and rook have not moved
@@ -298,14 +643,14 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
                 bool result;
                 if (dy > 0) {
                     // king side castle, need to check 2 squares
-                    result = threadLocalBoard.isLegalMove(startX, startY, startX, startY, true) &&
+                    result = !threadLocalBoard.inCheck(currentPlayer) &&
                         threadLocalBoard.board[startX][startY+1] == nullptr &&
                         threadLocalBoard.board[startX][startY+2] == nullptr &&
                         threadLocalBoard.isLegalMove(startX, startY, endX, startY + 1, true) &&
                         threadLocalBoard.isLegalMove(startX, startY, endX, endY, true);
                 } else {
                     // queen side castle, need to check 3 squares
-                    result = threadLocalBoard.isLegalMove(startX, startY, startX, startY, true) &&
+                    result = !threadLocalBoard.inCheck(currentPlayer) &&
                         threadLocalBoard.board[startX][startY-1] == nullptr &&
                         threadLocalBoard.board[startX][startY-2] == nullptr &&
                         threadLocalBoard.board[startX][startY-3] == nullptr &&
@@ -315,20 +660,16 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
                 }
                 if (result) {
                     auto [rookX, rookY] = kingPiece->getRookPosition(endX, endY, threadLocalBoard.board);
-                    Piece* rook = threadLocalBoard.board[rookX][rookY];
 
                     // move rook temporarily
                     if (dy > 0) { // kingside
-                        threadLocalBoard.board[rookX][rookY - 2] = rook;
-                        threadLocalBoard.board[rookX][rookY] = nullptr;
+                        threadLocalBoard.putPiece(rookX, rookY - 2, threadLocalBoard.takePiece(rookX, rookY));
                     } else { // queenside
-                        threadLocalBoard.board[rookX][rookY + 3] = rook;
-                        threadLocalBoard.board[rookX][rookY] = nullptr;
+                        threadLocalBoard.putPiece(rookX, rookY + 3, threadLocalBoard.takePiece(rookX, rookY));
                     }
 
                     // move king temporarily
-                    threadLocalBoard.board[endX][endY] = movingPiece;
-                    threadLocalBoard.board[startX][startY] = nullptr;
+                    threadLocalBoard.putPiece(endX, endY, threadLocalBoard.takePiece(startX, startY));
 
                     // update king's position
                     if (currentPlayer == 'W') {
@@ -339,19 +680,18 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
 
                     // special move and unmove for castling
                     // call minimax or evaluate the position
-                    eval = evaluatePosition(depth, currentPlayer, threadLocalBoard);
+                    threadLocalBoard.previousMove = {startX, startY, endX, endY};
+                    eval = evaluatePosition(depth, currentPlayer, threadLocalBoard, alpha, beta);
+                    threadLocalBoard.previousMove = lastMove;
 
                     // undo king move
-                    threadLocalBoard.board[startX][startY] = movingPiece;
-                    threadLocalBoard.board[endX][endY] = nullptr;
+                    threadLocalBoard.putPiece(startX, startY, threadLocalBoard.takePiece(endX, endY));
 
                     // undo rook move
                     if (dy > 0) { // kingside
-                        threadLocalBoard.board[rookX][rookY] = rook;
-                        threadLocalBoard.board[rookX][rookY - 2] = nullptr;
+                        threadLocalBoard.putPiece(rookX, rookY, threadLocalBoard.takePiece(rookX, rookY - 2));
                     } else { // queenside
-                        threadLocalBoard.board[rookX][rookY] = rook;
-                        threadLocalBoard.board[rookX][rookY + 3] = nullptr;
+                        threadLocalBoard.putPiece(rookX, rookY, threadLocalBoard.takePiece(rookX, rookY + 3));
                     }
 
                     // restore king's position
@@ -372,6 +712,9 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
         abs(get<2>(threadLocalBoard.previousMove) - get<0>(threadLocalBoard.previousMove)) == 2 &&
         abs(startY - get<1>(threadLocalBoard.previousMove)) == 1 &&
         startX == get<2>(threadLocalBoard.previousMove) &&
+        // only a pawn that just advanced two squares can be taken en passant
+        threadLocalBoard.board[get<2>(threadLocalBoard.previousMove)][get<3>(threadLocalBoard.previousMove)] &&
+        threadLocalBoard.board[get<2>(threadLocalBoard.previousMove)][get<3>(threadLocalBoard.previousMove)]->getPieceType() == PAWN &&
         endX == get<2>(threadLocalBoard.previousMove) + 
             ((threadLocalBoard.board[get<2>(threadLocalBoard.previousMove)][get<3>(threadLocalBoard.previousMove)]->getColor() == 'B') ? -1 : 1) &&
         endY == get<3>(threadLocalBoard.previousMove)) {
@@ -381,12 +724,10 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
         int capturedPawnY = get<3>(threadLocalBoard.previousMove);
 
         // temporarily remove the en passant captured pawn
-        enPassantCapturedPawn = threadLocalBoard.board[capturedPawnX][capturedPawnY];
-        threadLocalBoard.board[capturedPawnX][capturedPawnY] = nullptr;
+        enPassantCapturedPawn = threadLocalBoard.takePiece(capturedPawnX, capturedPawnY);
 
         // move the current pawn to its destination
-        threadLocalBoard.board[endX][endY] = movingPiece;
-        threadLocalBoard.board[startX][startY] = nullptr;
+        threadLocalBoard.putPiece(endX, endY, threadLocalBoard.takePiece(startX, startY));
 
         // check if the king is in check after this move
         auto [kingX, kingY] = (currentPlayer == 'W') ? threadLocalBoard.whiteKing : threadLocalBoard.blackKing;
@@ -406,17 +747,18 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
 
         // special move and unmove for enpassant
         // if valid, call minimax for the next depth
-        eval = evaluatePosition(depth, currentPlayer, threadLocalBoard);
+        threadLocalBoard.previousMove = {startX, startY, endX, endY};
+        eval = evaluatePosition(depth, currentPlayer, threadLocalBoard, alpha, beta);
+        threadLocalBoard.previousMove = lastMove;
 
         // undo the en passant move and restore the state
-        threadLocalBoard.board[startX][startY] = movingPiece;
-        threadLocalBoard.board[endX][endY] = nullptr;
-        threadLocalBoard.board[capturedPawnX][capturedPawnY] = enPassantCapturedPawn;
+        threadLocalBoard.putPiece(startX, startY, threadLocalBoard.takePiece(endX, endY));
+        threadLocalBoard.putPiece(capturedPawnX, capturedPawnY, enPassantCapturedPawn);
         return !isInCheck;
     }
     // make the move temporarily
-    threadLocalBoard.board[endX][endY] = movingPiece;
-    threadLocalBoard.board[startX][startY] = nullptr;
+    threadLocalBoard.takePiece(endX, endY);
+    threadLocalBoard.putPiece(endX, endY, threadLocalBoard.takePiece(startX, startY));
 
     // update king position if the moved piece is a king
     if (movingPiece->getType() == "King") {
@@ -441,11 +783,13 @@ bool Engine::moveAndUnmove(int startX, int startY, int endX, int endY, int &eval
     }
     // normal move and unmove
     // if valid, call minimax for the next depth
-    eval = evaluatePosition(depth, currentPlayer, threadLocalBoard);
+    threadLocalBoard.previousMove = {startX, startY, endX, endY};
+    eval = evaluatePosition(depth, currentPlayer, threadLocalBoard, alpha, beta);
+    threadLocalBoard.previousMove = lastMove;
     
     // undo the move to restore the original board state
-    threadLocalBoard.board[startX][startY] = movingPiece;
-    threadLocalBoard.board[endX][endY] = capturedPiece;
+    threadLocalBoard.putPiece(startX, startY, threadLocalBoard.takePiece(endX, endY));
+    threadLocalBoard.putPiece(endX, endY, capturedPiece);
     // restore king's position if it was moved
     if (movingPiece->getType() == "King") {
         if (currentPlayer == 'W') {
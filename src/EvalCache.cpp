@@ -0,0 +1,35 @@
+#include "EvalCache.h"
+
+EvalCache::EvalCache(size_t size) : entries(new std::atomic<uint64_t>[size]), mask(size - 1) {
+    clear();
+}
+
+bool EvalCache::probe(uint64_t key, int& score) const {
+    uint64_t entry = entries[key & mask].load(std::memory_order_relaxed);
+    if ((entry >> 32) == (key >> 32)) {
+        score = (int32_t)(uint32_t)entry;
+        return true;
+    }
+    return false;
+}
+
+void EvalCache::store(uint64_t key, int score) {
+    uint64_t entry = (key & 0xFFFFFFFF00000000ULL) | (uint32_t)score;
+    entries[key & mask].store(entry, std::memory_order_relaxed);
+}
+
+void EvalCache::clear() {
+    for (size_t i = 0; i <= mask; i++) {
+        entries[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void EvalCache::resize(size_t size) {
+    entries.reset(new std::atomic<uint64_t>[size]);
+    mask = size - 1;
+    clear();
+}
+
+size_t EvalCache::size() const {
+    return mask + 1;
+}
@@ -7,10 +7,18 @@ string King::getType() const {
     return "King";
 }
 
+PieceType King::getPieceType() const {
+    return KING;
+}
+
 void King::makeMove() {
     hasMoved = true;
 }
 
+void King::setMoved(bool moved) {
+    hasMoved = moved;
+}
+
 // should only be called after both checkPseudoCastle && isLegalMove is called and both are true
 pair<int, int> King::getRookPosition(int endX, int endY, const vector<vector<Piece*>>& board) const {
     pair<int, int> key = {endX, endY};
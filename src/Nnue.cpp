@@ -0,0 +1,206 @@
+#include "Nnue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNUE_SSE2
+#endif
+
+struct NnueNetwork {
+    alignas(32) int16_t hiddenBias[NNUE_HIDDEN];
+    alignas(32) int16_t hiddenWeights[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(32) int32_t l2Bias[NNUE_L2];
+    alignas(32) int8_t l2Weights[NNUE_L2][NNUE_HIDDEN];
+    alignas(32) int32_t l3Bias[NNUE_L3];
+    alignas(32) int8_t l3Weights[NNUE_L3][NNUE_L2];
+    int32_t outputBias;
+    alignas(32) int8_t outputWeights[NNUE_L3];
+};
+
+static std::unique_ptr<NnueNetwork> network;
+
+template <typename T>
+static bool readArray(std::ifstream& in, T* data, size_t count) {
+    in.read(reinterpret_cast<char*>(data), sizeof(T) * count);
+    return bool(in);
+}
+
+bool Nnue::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    char magic[4];
+    uint32_t version, hidden;
+    if (!readArray(in, magic, 4) || std::memcmp(magic, "BFNN", 4) != 0 ||
+        !readArray(in, &version, 1) || version != 1 ||
+        !readArray(in, &hidden, 1) || hidden != NNUE_HIDDEN) {
+        return false;
+    }
+    std::unique_ptr<NnueNetwork> loaded(new NnueNetwork());
+    bool ok = readArray(in, loaded->hiddenBias, NNUE_HIDDEN)
+        && readArray(in, &loaded->hiddenWeights[0][0], NNUE_INPUTS * NNUE_HIDDEN)
+        && readArray(in, loaded->l2Bias, NNUE_L2)
+        && readArray(in, &loaded->l2Weights[0][0], NNUE_L2 * NNUE_HIDDEN)
+        && readArray(in, loaded->l3Bias, NNUE_L3)
+        && readArray(in, &loaded->l3Weights[0][0], NNUE_L3 * NNUE_L2)
+        && readArray(in, &loaded->outputBias, 1)
+        && readArray(in, loaded->outputWeights, NNUE_L3);
+    // trailing bytes mean the file was written for a different layout
+    if (!ok || in.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+    network = std::move(loaded);
+    return true;
+}
+
+bool Nnue::isLoaded() {
+    return network != nullptr;
+}
+
+const char* Nnue::simdName() {
+#if defined(NNUE_AVX2)
+    return "AVX2";
+#elif defined(NNUE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void Nnue::resetAccumulator(int16_t* accumulator) {
+    std::memcpy(accumulator, network->hiddenBias, sizeof(network->hiddenBias));
+}
+
+void Nnue::addFeature(int16_t* accumulator, int feature) {
+    const int16_t* weights = network->hiddenWeights[feature];
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_add_epi16(acc, w));
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_add_epi16(acc, w));
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        accumulator[i] += weights[i];
+    }
+#endif
+}
+
+void Nnue::removeFeature(int16_t* accumulator, int feature) {
+    const int16_t* weights = network->hiddenWeights[feature];
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_sub_epi16(acc, w));
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_sub_epi16(acc, w));
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        accumulator[i] -= weights[i];
+    }
+#endif
+}
+
+// clips int16 values to 0..127 and narrows them to bytes, size is a multiple of 32
+static void clippedRelu(const int16_t* input, uint8_t* output, int size) {
+#if defined(NNUE_AVX2)
+    const __m256i max = _mm256_set1_epi16(127);
+    for (int i = 0; i < size; i += 32) {
+        __m256i a = _mm256_min_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)), max);
+        __m256i b = _mm256_min_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16)), max);
+        // packus saturates negatives to 0 but interleaves the 128-bit lanes, the permute undoes that
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+#elif defined(NNUE_SSE2)
+    const __m128i max = _mm_set1_epi16(127);
+    for (int i = 0; i < size; i += 16) {
+        __m128i a = _mm_min_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), max);
+        __m128i b = _mm_min_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8)), max);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(a, b));
+    }
+#else
+    for (int i = 0; i < size; i++) {
+        output[i] = (uint8_t)std::clamp<int>(input[i], 0, 127);
+    }
+#endif
+}
+
+// dot product of 0..127 activations with int8 weights, size is a multiple of 32
+static int32_t dot(const uint8_t* input, const int8_t* weights, int size) {
+#if defined(NNUE_AVX2)
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        // u8 * i8 pairs summed into int16 cannot saturate since inputs are at most 127
+        __m256i products = _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones);
+        sum = _mm256_add_epi32(sum, products);
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+#elif defined(NNUE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i));
+        // widen to int16, sign extending the weights
+        __m128i aLow = _mm_unpacklo_epi8(a, zero);
+        __m128i aHigh = _mm_unpackhi_epi8(a, zero);
+        __m128i wLow = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        __m128i wHigh = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(aLow, wLow));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(aHigh, wHigh));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < size; i++) {
+        sum += input[i] * weights[i];
+    }
+    return sum;
+#endif
+}
+
+int Nnue::evaluate(const int16_t* accumulator) {
+    alignas(32) uint8_t hidden[NNUE_HIDDEN];
+    alignas(32) uint8_t l2[NNUE_L2];
+    alignas(32) uint8_t l3[NNUE_L3];
+
+    clippedRelu(accumulator, hidden, NNUE_HIDDEN);
+    for (int i = 0; i < NNUE_L2; i++) {
+        int32_t sum = network->l2Bias[i] + dot(hidden, network->l2Weights[i], NNUE_HIDDEN);
+        l2[i] = (uint8_t)std::clamp(sum >> NNUE_SHIFT, 0, 127);
+    }
+    for (int i = 0; i < NNUE_L3; i++) {
+        int32_t sum = network->l3Bias[i] + dot(l2, network->l3Weights[i], NNUE_L2);
+        l3[i] = (uint8_t)std::clamp(sum >> NNUE_SHIFT, 0, 127);
+    }
+    int32_t output = network->outputBias + dot(l3, network->outputWeights, NNUE_L3);
+    return output / NNUE_OUTPUT_DIVISOR;
+}
@@ -0,0 +1,71 @@
+#include "PackedPosition.h"
+#include <algorithm>
+#include <cstring>
+
+PackedPosition packPosition(const Board& board, int score, uint8_t result) {
+    PackedPosition packed;
+    std::memset(&packed, 0, sizeof(packed));
+    packed.occupied = board.colorBitboards[0] | board.colorBitboards[1];
+    // codes of every occupied square, in square order
+    uint8_t codes[64];
+    for (int c = 0; c < 2; c++) {
+        for (int type = PAWN; type <= KING; type++) {
+            Bitboard pieces = board.pieceBitboards[c][type];
+            while (pieces) {
+                codes[popLsb(pieces)] = 1 + c * 6 + type;
+            }
+        }
+    }
+    Bitboard occupied = packed.occupied;
+    for (int index = 0; occupied && index < 32; index++) {
+        packed.pieces[index / 2] |= codes[popLsb(occupied)] << ((index % 2) * 4);
+    }
+
+    if (board.getSideToMove() == 'B') {
+        packed.flags |= PACKED_BLACK_TO_MOVE;
+    }
+    for (int c = 0; c < 2; c++) {
+        for (int kingSide = 0; kingSide < 2; kingSide++) {
+            if (board.hasCastlingRight(c == 0 ? 'W' : 'B', kingSide)) {
+                packed.flags |= 1 << (PACKED_CASTLING_SHIFT + 2 * c + kingSide);
+            }
+        }
+    }
+    packed.enPassant = board.getEnPassantFile() + 1;
+    packed.halfmoveClock = std::min(board.getHalfmoveClock(), 255);
+    packed.fullmoveNumber = std::min(board.getFullmoveNumber(), 65535);
+    packed.score = (score == PACKED_NO_SCORE) ? PACKED_NO_SCORE : std::clamp(score, INT16_MIN + 1, INT16_MAX);
+    packed.result = result;
+    return packed;
+}
+
+bool PackedDataset::open(const std::string& path) {
+    if (!file.open(path) || file.size() % sizeof(PackedPosition) != 0) {
+        file.close();
+        count = 0;
+        return false;
+    }
+    count = file.size() / sizeof(PackedPosition);
+    return true;
+}
+
+bool PackedDataset::isOpen() const {
+    return file.isOpen();
+}
+
+size_t PackedDataset::size() const {
+    return count;
+}
+
+// mappings start on a page boundary, so every record is aligned
+const PackedPosition& PackedDataset::operator[](size_t index) const {
+    return begin()[index];
+}
+
+const PackedPosition* PackedDataset::begin() const {
+    return reinterpret_cast<const PackedPosition*>(file.data());
+}
+
+const PackedPosition* PackedDataset::end() const {
+    return begin() + count;
+}
@@ -5,10 +5,18 @@ Pawn::Pawn(char color) : Piece(color), hasMoved(false) {}
 
 string Pawn::getType() const { return "Pawn"; }
 
+PieceType Pawn::getPieceType() const {
+    return PAWN;
+}
+
 void Pawn::makeMove() {
     hasMoved = true;
 }
 
+void Pawn::setMoved(bool moved) {
+    hasMoved = moved;
+}
+
 bool Pawn::isValidPieceMove(int startX, int startY, int endX, int endY, const vector<vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const {
     int direction = (color == 'W') ? -1 : 1;
 
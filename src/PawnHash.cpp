@@ -0,0 +1,124 @@
+#include "PawnHash.h"
+
+static const Score doubledPenalty = makeScore(10, 20);
+static const Score isolatedPenalty = makeScore(10, 15);
+static const Score backwardPenalty = makeScore(8, 10);
+// indexed by rank counted from the pawn owner's back rank
+static const Score passedBonus[8] = {
+    makeScore(0, 0), makeScore(5, 10), makeScore(5, 15), makeScore(10, 30),
+    makeScore(25, 55), makeScore(45, 90), makeScore(80, 140), makeScore(0, 0)
+};
+
+// squares in front of a pawn, white pawns advance towards row 0
+struct PawnSpans {
+    // same file, strictly ahead
+    Bitboard front[2][64];
+    // adjacent files, strictly ahead
+    Bitboard attack[2][64];
+    // adjacent files, all rows
+    Bitboard adjacentFiles[8];
+};
+
+static constexpr PawnSpans buildPawnSpans() {
+    PawnSpans spans{};
+    for (int col = 0; col < 8; col++) {
+        if (col > 0) {
+            spans.adjacentFiles[col] |= fileABitboard << (col - 1);
+        }
+        if (col < 7) {
+            spans.adjacentFiles[col] |= fileABitboard << (col + 1);
+        }
+    }
+    for (int square = 0; square < 64; square++) {
+        int row = square / 8;
+        int col = square % 8;
+        for (int r = 0; r < 8; r++) {
+            Bitboard rowMask = 0xFFULL << (r * 8);
+            int c = (r < row) ? 0 : (r > row) ? 1 : -1;
+            if (c >= 0) {
+                spans.front[c][square] |= rowMask & (fileABitboard << col);
+                spans.attack[c][square] |= rowMask & spans.adjacentFiles[col];
+            }
+        }
+    }
+    return spans;
+}
+
+static constexpr PawnSpans pawnSpans = buildPawnSpans();
+
+PawnHashTable::PawnHashTable() : entries(PAWN_HASH_SIZE) {}
+
+const PawnEntry& PawnHashTable::probe(const Board& board) {
+    PawnEntry& entry = entries[board.pawnKey & (PAWN_HASH_SIZE - 1)];
+    if (entry.key == board.pawnKey) {
+        return entry;
+    }
+    entry.key = board.pawnKey;
+    evaluatePawns(board, entry);
+    return entry;
+}
+
+bool PawnHashTable::contains(const Board& board) const {
+    return entries[board.pawnKey & (PAWN_HASH_SIZE - 1)].key == board.pawnKey;
+}
+
+void PawnHashTable::evaluatePawns(const Board& board, PawnEntry& entry) const {
+    Score sideScore[2] = {0, 0};
+    Bitboard allPawns = board.pieceBitboards[0][PAWN] | board.pieceBitboards[1][PAWN];
+
+    for (int c = 0; c < 2; c++) {
+        Bitboard ourPawns = board.pieceBitboards[c][PAWN];
+        Bitboard theirPawns = board.pieceBitboards[c ^ 1][PAWN];
+        entry.passedPawns[c] = 0;
+        entry.pawnAttackSpans[c] = 0;
+
+        Bitboard pawns = ourPawns;
+        while (pawns) {
+            int square = popLsb(pawns);
+            int col = square % 8;
+            int rank = (c == 0) ? 7 - square / 8 : square / 8;
+            Bitboard adjacent = ourPawns & pawnSpans.adjacentFiles[col];
+            bool blockedByOwn = ourPawns & pawnSpans.front[c][square];
+
+            entry.pawnAttackSpans[c] |= pawnSpans.attack[c][square];
+
+            // an own pawn further up the same file
+            if (blockedByOwn) {
+                sideScore[c] -= doubledPenalty;
+            }
+
+            if (!adjacent) {
+                // no own pawns on either neighbouring file
+                sideScore[c] -= isolatedPenalty;
+            } else if (rank < 7 && !(adjacent & ~pawnSpans.attack[c][square])) {
+                // all neighbours are ahead, so nothing can defend the stop square
+                int stopSquare = (c == 0) ? square - 8 : square + 8;
+                if (attackTables.pawn[c][stopSquare] & theirPawns) {
+                    sideScore[c] -= backwardPenalty;
+                }
+            }
+
+            // no enemy pawn can block or capture it on the way
+            if (!blockedByOwn && !(theirPawns & (pawnSpans.front[c][square] | pawnSpans.attack[c][square]))) {
+                entry.passedPawns[c] |= 1ULL << square;
+                sideScore[c] += passedBonus[rank];
+            }
+        }
+    }
+
+    entry.openFiles = 0;
+    entry.semiOpenFiles[0] = entry.semiOpenFiles[1] = 0;
+    for (int col = 0; col < 8; col++) {
+        Bitboard file = fileABitboard << col;
+        if (!(allPawns & file)) {
+            entry.openFiles |= 1 << col;
+        }
+        for (int c = 0; c < 2; c++) {
+            if (!(board.pieceBitboards[c][PAWN] & file)) {
+                entry.semiOpenFiles[c] |= 1 << col;
+            }
+        }
+    }
+
+    entry.score = sideScore[0] - sideScore[1];
+}
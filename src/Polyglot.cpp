@@ -0,0 +1,218 @@
+#include "Polyglot.h"
+#include "Zobrist.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#define POLYGLOT_ENTRY_SIZE 16
+#define POLYGLOT_CASTLE 768
+#define POLYGLOT_EN_PASSANT 772
+#define POLYGLOT_TURN 780
+
+struct PolyglotRandom {
+    uint64_t values[POLYGLOT_RANDOM_COUNT];
+};
+
+static constexpr PolyglotRandom buildPolyglotRandom() {
+    PolyglotRandom table{};
+    uint64_t state = 0x506F6C79676C6F74ULL;
+    for (int i = 0; i < POLYGLOT_RANDOM_COUNT; i++) {
+        table.values[i] = splitMix64(state);
+    }
+    return table;
+}
+
+// replaced by loadPolyglotRandom(), read only after that
+static PolyglotRandom polyglotRandom = buildPolyglotRandom();
+static bool publishedRandom = false;
+
+static uint64_t computeKey(const PolyglotRandom& random, const Board& board, char sideToMove) {
+    uint64_t key = 0;
+    for (int c = 0; c < 2; c++) {
+        for (int type = PAWN; type <= KING; type++) {
+            // Polyglot orders black pawn, white pawn, black knight, ...
+            int kind = 2 * type + (c == 0 ? 1 : 0);
+            Bitboard pieces = board.pieceBitboards[c][type];
+            while (pieces) {
+                // Polyglot counts rows from rank 1, Board from rank 8
+                int square = popLsb(pieces) ^ 56;
+                key ^= random.values[64 * kind + square];
+            }
+        }
+    }
+    const std::pair<char, bool> rights[] = {{'W', true}, {'W', false}, {'B', true}, {'B', false}};
+    for (int i = 0; i < 4; i++) {
+        if (board.hasCastlingRight(rights[i].first, rights[i].second)) {
+            key ^= random.values[POLYGLOT_CASTLE + i];
+        }
+    }
+    // the en passant file only counts when a pawn can actually capture
+    auto [fromRow, fromCol, toRow, toCol] = board.previousMove;
+    Piece* moved = (toRow >= 0) ? board.board[toRow][toCol] : nullptr;
+    if (moved && moved->getPieceType() == PAWN && moved->getColor() != sideToMove &&
+        std::abs(toRow - fromRow) == 2) {
+        for (int col = toCol - 1; col <= toCol + 1; col += 2) {
+            Piece* capturer = (col >= 0 && col < 8) ? board.board[toRow][col] : nullptr;
+            if (capturer && capturer->getPieceType() == PAWN && capturer->getColor() == sideToMove) {
+                key ^= random.values[POLYGLOT_EN_PASSANT + toCol];
+                break;
+            }
+        }
+    }
+    if (sideToMove == 'W') {
+        key ^= random.values[POLYGLOT_TURN];
+    }
+    return key;
+}
+
+bool loadPolyglotRandom(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    std::string contents = text.str();
+    PolyglotRandom table{};
+    int count = 0;
+    size_t position = 0;
+    while ((position = contents.find("0x", position)) != std::string::npos) {
+        if (count == POLYGLOT_RANDOM_COUNT) {
+            return false;
+        }
+        table.values[count++] = std::strtoull(contents.c_str() + position + 2, nullptr, 16);
+        position += 2;
+    }
+    if (count != POLYGLOT_RANDOM_COUNT) {
+        return false;
+    }
+    // catches other tables and numbers out of order
+    Board start;
+    if (!start.loadFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") ||
+        computeKey(table, start, 'W') != POLYGLOT_START_KEY) {
+        return false;
+    }
+    polyglotRandom = table;
+    publishedRandom = true;
+    return true;
+}
+
+bool polyglotRandomLoaded() {
+    return publishedRandom;
+}
+
+uint64_t polyglotKey(const Board& board, char sideToMove) {
+    return computeKey(polyglotRandom, board, sideToMove);
+}
+
+BookMove decodePolyglotMove(uint16_t move, const Board& board) {
+    BookMove result;
+    result.to = {7 - ((move >> 3) & 7), move & 7};
+    result.from = {7 - ((move >> 9) & 7), (move >> 6) & 7};
+    // Polyglot numbers promotions knight = 1 to queen = 4, like PieceType
+    result.promotion = (move >> 12) & 7;
+    result.weight = 0;
+    // castling is stored as the king taking its own rook
+    Piece* piece = board.board[result.from.first][result.from.second];
+    Piece* target = board.board[result.to.first][result.to.second];
+    if (piece && piece->getPieceType() == KING && target && target->getPieceType() == ROOK &&
+        target->getColor() == piece->getColor()) {
+        result.to.second = (result.to.second > result.from.second) ? 6 : 2;
+    }
+    return result;
+}
+
+uint16_t encodePolyglotMove(const BookMove& move, const Board& board) {
+    int toCol = move.to.second;
+    Piece* piece = board.board[move.from.first][move.from.second];
+    if (piece && piece->getPieceType() == KING && std::abs(move.to.second - move.from.second) == 2) {
+        toCol = (move.to.second > move.from.second) ? 7 : 0;
+    }
+    return (uint16_t)(toCol | (7 - move.to.first) << 3 | move.from.second << 6 |
+                      (7 - move.from.first) << 9 | move.promotion << 12);
+}
+
+static uint64_t readBigEndian(const uint8_t* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+bool PolyglotBook::open(const std::string& path) {
+    if (!publishedRandom || !file.open(path) || file.size() % POLYGLOT_ENTRY_SIZE != 0) {
+        file.close();
+        entryCount = 0;
+        return false;
+    }
+    entryCount = file.size() / POLYGLOT_ENTRY_SIZE;
+    return true;
+}
+
+bool PolyglotBook::isOpen() const {
+    return file.isOpen();
+}
+
+size_t PolyglotBook::size() const {
+    return entryCount;
+}
+
+std::vector<BookMove> PolyglotBook::probe(const Board& board, char sideToMove) const {
+    std::vector<BookMove> moves;
+    if (!file.isOpen()) {
+        return moves;
+    }
+    uint64_t key = polyglotKey(board, sideToMove);
+    const uint8_t* entries = file.data();
+    // first entry with this key
+    size_t low = 0, high = entryCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (readBigEndian(entries + middle * POLYGLOT_ENTRY_SIZE, 8) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (size_t i = low; i < entryCount; i++) {
+        const uint8_t* entry = entries + i * POLYGLOT_ENTRY_SIZE;
+        if (readBigEndian(entry, 8) != key) {
+            break;
+        }
+        BookMove move = decodePolyglotMove((uint16_t)readBigEndian(entry + 8, 2), board);
+        move.weight = (uint16_t)readBigEndian(entry + 10, 2);
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+bool PolyglotBook::pickMove(const Board& board, char sideToMove, bool bestOnly, BookMove& move) const {
+    std::vector<BookMove> moves = probe(board, sideToMove);
+    if (moves.empty()) {
+        return false;
+    }
+    uint32_t totalWeight = 0;
+    for (const BookMove& candidate : moves) {
+        totalWeight += candidate.weight;
+    }
+    if (bestOnly || totalWeight == 0) {
+        move = moves[0];
+        for (const BookMove& candidate : moves) {
+            if (candidate.weight > move.weight) {
+                move = candidate;
+            }
+        }
+        return true;
+    }
+    uint32_t pick = std::uniform_int_distribution<uint32_t>(0, totalWeight - 1)(rng);
+    for (const BookMove& candidate : moves) {
+        if (pick < candidate.weight) {
+            move = candidate;
+            return true;
+        }
+        pick -= candidate.weight;
+    }
+    move = moves.back();
+    return true;
+}
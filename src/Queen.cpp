@@ -6,6 +6,10 @@ string Queen::getType() const {
     return "Queen";
 }
 
+PieceType Queen::getPieceType() const {
+    return QUEEN;
+}
+
 bool Queen::isValidPieceMove(int startX, int startY, int endX, int endY, const vector<vector<Piece*>>& board, tuple<int, int, int, int> previousMove) const {
     int dx = abs(endX - startX);
     int dy = abs(endY - startY);
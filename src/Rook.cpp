@@ -6,10 +6,18 @@ string Rook::getType() const {
     return "Rook";
 }
 
+PieceType Rook::getPieceType() const {
+    return ROOK;
+}
+
 void Rook::makeMove() {
     hasMoved = true;
 }
 
+void Rook::setMoved(bool moved) {
+    hasMoved = moved;
+}
+
 bool Rook::canCastle() const {
     return !hasMoved;
 }
@@ -0,0 +1,119 @@
+#include "San.h"
+#include <cctype>
+#include <cstring>
+
+static int pieceTypeFromLetter(char letter) {
+    switch (letter) {
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default: return -1;
+    }
+}
+
+bool parseSan(Board& board, const std::string& san, char sideToMove, SanMove& move) {
+    std::string text = san;
+    // check, mate and annotation marks say nothing about the move itself
+    while (!text.empty() && std::strchr("+#!?", text.back())) {
+        text.pop_back();
+    }
+    int homeRow = (sideToMove == 'W') ? 7 : 0;
+
+    if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+        move = {homeRow, 4, homeRow, (text.size() == 3) ? 6 : 2, QUEEN};
+        Piece* king = board.board[homeRow][4];
+        return king && king->getColor() == sideToMove && king->getPieceType() == KING &&
+            king->isValidPieceMove(move.fromX, move.fromY, move.toX, move.toY, board.board, board.previousMove) &&
+            board.isLegalMove(move.fromX, move.fromY, move.toX, move.toY);
+    }
+
+    move.promotion = QUEEN;
+    size_t equals = text.find('=');
+    if (equals != std::string::npos) {
+        if (equals + 1 >= text.size() || pieceTypeFromLetter(text[equals + 1]) < KNIGHT) {
+            return false;
+        }
+        move.promotion = pieceTypeFromLetter(text[equals + 1]);
+        text.resize(equals);
+    } else if (text.size() > 2 && pieceTypeFromLetter(text.back()) > PAWN && text[0] >= 'a' && text[0] <= 'h') {
+        // promotion written without '=', e.g. "e8Q"
+        move.promotion = pieceTypeFromLetter(text.back());
+        text.pop_back();
+    }
+
+    int type = PAWN;
+    size_t start = 0;
+    if (!text.empty() && pieceTypeFromLetter(text[0]) > PAWN) {
+        type = pieceTypeFromLetter(text[0]);
+        start = 1;
+    }
+    if (text.size() < start + 2) {
+        return false;
+    }
+    char file = text[text.size() - 2];
+    char rank = text[text.size() - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
+        return false;
+    }
+    move.toX = '8' - rank;
+    move.toY = file - 'a';
+
+    // anything between the piece letter and the destination disambiguates
+    int fromRow = -1, fromCol = -1;
+    for (size_t i = start; i < text.size() - 2; i++) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'h') {
+            fromCol = c - 'a';
+        } else if (c >= '1' && c <= '8') {
+            fromRow = '8' - c;
+        } else if (c != 'x' && c != ':') {
+            return false;
+        }
+    }
+
+    int found = 0;
+    Bitboard candidates = board.pieceBitboards[colorIndex(sideToMove)][type];
+    while (candidates) {
+        int square = popLsb(candidates);
+        int row = square / 8;
+        int col = square % 8;
+        if ((fromRow >= 0 && row != fromRow) || (fromCol >= 0 && col != fromCol)) {
+            continue;
+        }
+        if (board.board[row][col]->isValidPieceMove(row, col, move.toX, move.toY, board.board, board.previousMove) &&
+            board.isLegalMove(row, col, move.toX, move.toY)) {
+            move.fromX = row;
+            move.fromY = col;
+            found++;
+        }
+    }
+    return found == 1;
+}
+
+bool parseCoordinateMove(const std::string& text, SanMove& move) {
+    if (text.size() < 4 || text.size() > 5 ||
+        text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8' ||
+        text[2] < 'a' || text[2] > 'h' || text[3] < '1' || text[3] > '8') {
+        return false;
+    }
+    move = {'8' - text[1], text[0] - 'a', '8' - text[3], text[2] - 'a', QUEEN};
+    if (text.size() == 5) {
+        // promotion letters are lower case here
+        move.promotion = pieceTypeFromLetter((char)std::toupper((unsigned char)text[4]));
+        if (move.promotion < KNIGHT || move.promotion > QUEEN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string coordinateMove(const Board& board, int fromX, int fromY, int toX, int toY) {
+    std::string text = {(char)('a' + fromY), (char)('8' - fromX), (char)('a' + toY), (char)('8' - toX)};
+    Piece* piece = board.board[fromX][fromY];
+    if (piece && piece->getPieceType() == PAWN && (toX == 0 || toX == 7)) {
+        text += 'q';
+    }
+    return text;
+}
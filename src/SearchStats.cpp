@@ -0,0 +1,91 @@
+#include "SearchStats.h"
+#include <ostream>
+#include <sstream>
+
+SearchStats& SearchStats::operator+=(const SearchStats& other) {
+    enabled |= other.enabled;
+    for (int depth = 0; depth < STATS_MAX_DEPTH; depth++) {
+        nodes[depth] += other.nodes[depth];
+        moves[depth] += other.moves[depth];
+        iterationNodes[depth] += other.iterationNodes[depth];
+    }
+    betaCutoffs += other.betaCutoffs;
+    firstMoveCutoffs += other.firstMoveCutoffs;
+    evalCalls += other.evalCalls;
+    evalCacheHits += other.evalCacheHits;
+    lazyEvalCalls += other.lazyEvalCalls;
+    lazyExits += other.lazyExits;
+    pawnHashHits += other.pawnHashHits;
+    moveGenTime += other.moveGenTime;
+    evalTime += other.evalTime;
+    return *this;
+}
+
+void SearchStats::clear() {
+    bool wasEnabled = enabled;
+    *this = SearchStats();
+    enabled = wasEnabled;
+}
+
+static double ratio(uint64_t part, uint64_t whole) {
+    return whole ? (double)part / whole : 0;
+}
+
+void SearchStats::print(std::ostream& out) const {
+    if (!enabled) {
+        out << "search statistics are not compiled in, build with SEARCH_STATS" << std::endl;
+        return;
+    }
+    uint64_t totalNodes = 0;
+    for (uint64_t count : nodes) {
+        totalNodes += count;
+    }
+    out << "nodes " << totalNodes << " leaves " << evalCalls << " beta cutoffs " << betaCutoffs
+        << " first move cutoffs " << ratio(firstMoveCutoffs, betaCutoffs) * 100 << "%" << std::endl;
+    out << "eval cache hits " << ratio(evalCacheHits, evalCalls) * 100 << "% lazy exits "
+        << ratio(lazyExits, lazyEvalCalls) * 100 << "% of " << lazyEvalCalls
+        << " pawn hash hits " << ratio(pawnHashHits, lazyEvalCalls) * 100 << "%" << std::endl;
+    out << "move generation " << moveGenTime / 1000000 << " ms evaluation " << evalTime / 1000000 << " ms" << std::endl;
+    out << "branching factor by remaining depth";
+    for (int depth = STATS_MAX_DEPTH - 1; depth > 0; depth--) {
+        if (nodes[depth]) {
+            out << " " << depth << ":" << ratio(moves[depth], nodes[depth]);
+        }
+    }
+    out << std::endl;
+    out << "nodes by iteration";
+    for (int depth = 1; depth < STATS_MAX_DEPTH; depth++) {
+        if (iterationNodes[depth]) {
+            out << " " << depth << ":" << iterationNodes[depth];
+        }
+    }
+    out << std::endl;
+}
+
+std::string SearchStats::toJson() const {
+    std::ostringstream out;
+    auto list = [&](const uint64_t (&values)[STATS_MAX_DEPTH]) {
+        // up to the deepest depth with a count, index = depth
+        int last = STATS_MAX_DEPTH - 1;
+        while (last > 0 && !values[last]) {
+            last--;
+        }
+        out << "[";
+        for (int depth = 0; depth <= last; depth++) {
+            out << (depth ? "," : "") << values[depth];
+        }
+        out << "]";
+    };
+    out << "{\"enabled\":" << (enabled ? "true" : "false") << ",\"nodes\":";
+    list(nodes);
+    out << ",\"moves\":";
+    list(moves);
+    out << ",\"iterationNodes\":";
+    list(iterationNodes);
+    out << ",\"betaCutoffs\":" << betaCutoffs << ",\"firstMoveCutoffs\":" << firstMoveCutoffs
+        << ",\"evalCalls\":" << evalCalls << ",\"evalCacheHits\":" << evalCacheHits
+        << ",\"lazyEvalCalls\":" << lazyEvalCalls << ",\"lazyExits\":" << lazyExits
+        << ",\"pawnHashHits\":" << pawnHashHits << ",\"moveGenTime\":" << moveGenTime
+        << ",\"evalTime\":" << evalTime << "}";
+    return out.str();
+}
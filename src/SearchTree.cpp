@@ -0,0 +1,119 @@
+#include "SearchTree.h"
+#include "Polyglot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// what the calling search thread is recording: whether its current root
+// move is in the chosen subtree, the iteration, and the open nodes
+struct RecorderContext {
+    bool active = false;
+    int iteration = 0;
+    std::vector<uint32_t> path;
+};
+
+static thread_local RecorderContext context;
+
+SearchTreeRecorder::SearchTreeRecorder(size_t maxNodes) : nodes(maxNodes) {}
+
+void SearchTreeRecorder::setSubtree(int from, int to) {
+    subtreeFrom = from;
+    subtreeTo = to;
+}
+
+void SearchTreeRecorder::clear() {
+    used = 0;
+}
+
+size_t SearchTreeRecorder::size() const {
+    return std::min<uint64_t>(used.load(), nodes.size());
+}
+
+bool SearchTreeRecorder::isFull() const {
+    return used.load() >= nodes.size();
+}
+
+const SearchTreeNode* SearchTreeRecorder::data() const {
+    return nodes.data();
+}
+
+void SearchTreeRecorder::beginRootMove(int iteration, int from, int to) {
+    context.active = subtreeFrom < 0 || (from == subtreeFrom && to == subtreeTo);
+    context.iteration = iteration;
+    context.path.clear();
+}
+
+SearchTreeNode* SearchTreeRecorder::enter(const Board& board, char currentPlayer, int depth, int alpha, int beta) {
+    if (!context.active) {
+        return nullptr;
+    }
+    uint64_t index = used.fetch_add(1, std::memory_order_relaxed);
+    if (index >= nodes.size()) {
+        // keeps used from growing without bound
+        used.store(nodes.size(), std::memory_order_relaxed);
+        return nullptr;
+    }
+    SearchTreeNode& node = nodes[index];
+    node.key = polyglotKey(board, currentPlayer);
+    node.alpha = alpha;
+    node.beta = beta;
+    node.score = 0;
+    node.parent = context.path.empty() ? SEARCH_TREE_ROOT : context.path.back();
+    node.depth = (uint8_t)depth;
+    node.iteration = (uint8_t)context.iteration;
+    auto [fromX, fromY, toX, toY] = board.previousMove;
+    node.from = (fromX < 0) ? SEARCH_TREE_NO_SQUARE : (uint8_t)(fromX * 8 + fromY);
+    node.to = (toX < 0) ? SEARCH_TREE_NO_SQUARE : (uint8_t)(toX * 8 + toY);
+    node.movesSearched = 0;
+    node.reason = TREE_SEARCHED;
+    node.side = (uint8_t)colorIndex(currentPlayer);
+    context.path.push_back((uint32_t)index);
+    return &node;
+}
+
+void SearchTreeRecorder::leave(SearchTreeNode* node, int score) {
+    node->score = score;
+    context.path.pop_back();
+}
+
+bool SearchTreeRecorder::write(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    SearchTreeHeader header;
+    std::memcpy(header.magic, "BFST", 4);
+    header.version = SEARCH_TREE_VERSION;
+    header.count = size();
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+        std::fwrite(nodes.data(), sizeof(SearchTreeNode), header.count, file) == header.count;
+    return std::fclose(file) == 0 && ok;
+}
+
+bool readSearchTree(const std::string& path, std::vector<SearchTreeNode>& nodes) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    SearchTreeHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && std::memcmp(header.magic, "BFST", 4) == 0 &&
+        header.version == SEARCH_TREE_VERSION;
+    // the count must match the file before anything is allocated for it
+    if (ok) {
+        ok = std::fseek(file, 0, SEEK_END) == 0;
+        long size = ok ? std::ftell(file) : -1;
+        uint64_t bytes = (size >= (long)sizeof(header)) ? (uint64_t)size - sizeof(header) : 1;
+        ok = bytes % sizeof(SearchTreeNode) == 0 && header.count == bytes / sizeof(SearchTreeNode) &&
+            std::fseek(file, sizeof(header), SEEK_SET) == 0;
+    }
+    if (ok) {
+        nodes.resize(header.count);
+        ok = std::fread(nodes.data(), sizeof(SearchTreeNode), header.count, file) == header.count;
+    }
+    std::fclose(file);
+    // nodes are written after their parent, which keeps walks towards the root finite
+    for (size_t i = 0; ok && i < nodes.size(); i++) {
+        ok = nodes[i].parent == SEARCH_TREE_ROOT || nodes[i].parent < i;
+    }
+    return ok;
+}
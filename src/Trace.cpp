@@ -0,0 +1,142 @@
+#include "Trace.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    int64_t value;
+    char detail[8];
+};
+
+// written by one thread only; head counts every event ever recorded, so
+// the last TRACE_BUFFER_EVENTS of them are in the ring
+struct TraceBuffer {
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+    std::atomic<uint64_t> head{0};
+    int id = 0;
+    const char* threadName = "thread";
+};
+
+std::atomic<bool> Trace::enabled{false};
+
+// guards the buffer lists, taken once per thread and when writing
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+static std::vector<TraceBuffer*> freeBuffers;
+static std::atomic<uint64_t> epoch{0};
+
+// the calling thread's buffer, returned to the pool when the thread exits
+struct BufferLease {
+    TraceBuffer* buffer = nullptr;
+    ~BufferLease() {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            freeBuffers.push_back(buffer);
+        }
+    }
+};
+
+static thread_local BufferLease lease;
+
+static TraceBuffer* threadBuffer() {
+    if (!lease.buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (!freeBuffers.empty()) {
+            lease.buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+        } else {
+            buffers.push_back(std::make_unique<TraceBuffer>());
+            buffers.back()->id = (int)buffers.size();
+            lease.buffer = buffers.back().get();
+        }
+    }
+    return lease.buffer;
+}
+
+static uint64_t steadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::start() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& buffer : buffers) {
+        buffer->head.store(0, std::memory_order_relaxed);
+    }
+    epoch = steadyNanoseconds();
+    enabled = true;
+}
+
+void Trace::stop() {
+    enabled = false;
+}
+
+uint64_t Trace::now() {
+    return steadyNanoseconds() - epoch.load(std::memory_order_relaxed);
+}
+
+void Trace::setThreadName(const char* name) {
+    threadBuffer()->threadName = name;
+}
+
+void Trace::record(const char* name, uint64_t start, uint64_t end, int64_t value, const char* detail) {
+    TraceBuffer* buffer = threadBuffer();
+    uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[index % TRACE_BUFFER_EVENTS];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    event.value = value;
+    for (int i = 0; i < 8; i++) {
+        event.detail[i] = detail[i];
+    }
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::write(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    // one row per buffer, timestamps in microseconds
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"BadFish\"}}");
+    for (auto& buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == 0) {
+            continue;
+        }
+        std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+                     buffer->id, buffer->threadName, buffer->id);
+        uint64_t first = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+        for (uint64_t index = first; index < head; index++) {
+            const TraceEvent& event = buffer->events[index % TRACE_BUFFER_EVENTS];
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                         event.name, buffer->id, event.start / 1000.0, (event.end - event.start) / 1000.0);
+            const char* separator = "";
+            if (event.value != -1) {
+                std::fprintf(file, "\"value\":%lld", (long long)event.value);
+                separator = ",";
+            }
+            if (event.detail[0]) {
+                // details are moves and short labels, anything that would need escaping is dropped
+                std::fprintf(file, "%s\"detail\":\"", separator);
+                for (const char* c = event.detail; *c; c++) {
+                    if (*c != '"' && *c != '\\' && (unsigned char)*c >= 0x20) {
+                        std::fputc(*c, file);
+                    }
+                }
+                std::fputc('"', file);
+            }
+            std::fprintf(file, "}}");
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
@@ -5,10 +5,61 @@
 #include <chrono>
 #include "Board.h"
 #include "Engine.h"
+#include "Bitbase.h"
+#include "Polyglot.h"
+#include "Trace.h"
 
-int main() {
+int main(int argc, char** argv) {
+    // the build picks the default mode, -computer or -pvp override it
+#ifdef COMPUTER_MODE
+    bool computerMode = true;
+#else
+    bool computerMode = false;
+#endif
+    // -trace FILE records frames and searches, written when the window closes
+    std::string traceFile;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-computer") {
+            computerMode = true;
+        } else if (arg == "-pvp") {
+            computerMode = false;
+        } else if (arg == "-trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        }
+    }
+    if (!traceFile.empty()) {
+        Trace::setThreadName("gui");
+        Trace::start();
+    }
     Board board;
     Engine engine(board, 'B');
+#ifdef BITBASE_DIR
+    std::cout << "Loaded " << loadBitbases(BITBASE_DIR) << " endgame bitbases" << std::endl;
+#endif
+#ifdef BOOK_RANDOM_FILE
+    if (!loadPolyglotRandom(BOOK_RANDOM_FILE)) {
+        std::cerr << "Could not read Polyglot random numbers from " << BOOK_RANDOM_FILE << std::endl;
+    }
+#endif
+#ifdef BOOK_FILE
+    PolyglotBook book;
+    if (book.open(BOOK_FILE)) {
+        engine.setBook(&book);
+        std::cout << "Opening book with " << book.size() << " entries" << std::endl;
+    } else {
+        std::cerr << "Could not open " << BOOK_FILE
+                  << (polyglotRandomLoaded() ? "" : ", it needs the Polyglot random numbers from BOOK_RANDOM_FILE") << std::endl;
+    }
+#endif
+#ifdef NNUE_FILE
+    if (Nnue::load(NNUE_FILE)) {
+        engine.setUseNnue(true);
+        std::cout << "Using NNUE evaluator (" << Nnue::simdName() << ")" << std::endl;
+    } else {
+        std::cerr << "Could not load " << NNUE_FILE << ", using the classic evaluator" << std::endl;
+    }
+#endif
     // board.initialise();
     // standard
     board.loadFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
@@ -70,46 +121,14 @@ int main() {
     auto [px, py, px1, py1] = board.previousMove;
 
     while (window.isOpen()) {
+        TraceSpan frameSpan("frame");
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed)
                 window.close();
 
-            #ifndef COMPUTER_MODE
-
-            // player vs player Mode (testing for me basically)
-            if (event.type == sf::Event::MouseButtonPressed) {
-                if (event.mouseButton.button == sf::Mouse::Left) {
-                    int x = event.mouseButton.x / squareSize;
-                    int y = event.mouseButton.y / squareSize;
-
-                    if (selectedX == -1 && selectedY == -1) {
-                        // selecting a piece
-                        selectedPiece = board.getPieceAt(y, x);
-                        if (selectedPiece && board.getPieceColor(y, x) == currentPlayer) {
-                            selectedX = x;
-                            selectedY = y;
-                            legalMoves = board.getLegalMoves(y, x, currentPlayer);
-                        }
-                    } else {
-                        // moving a piece
-                        auto moveIt = std::find(legalMoves.begin(), legalMoves.end(), std::make_pair(y, x));
-                        if (moveIt != legalMoves.end()) {
-                            if (board.movePiece(selectedY, selectedX, y, x, currentPlayer)) {
-                                currentPlayer = (currentPlayer == 'W' ? 'B' : 'W');
-                                std::tie(px, py) = {y, x};
-                                std::tie(px1, py1) = {selectedY, selectedX};
-                            }
-                        }
-                        selectedX = selectedY = -1;
-                        legalMoves.clear();
-                    }
-                }
-            }
-
-            #else
-            // player vs computer Mode
-            if (currentPlayer == 'W') {
+            if (!computerMode) {
+                // player vs player Mode (testing for me basically)
                 if (event.type == sf::Event::MouseButtonPressed) {
                     if (event.mouseButton.button == sf::Mouse::Left) {
                         int x = event.mouseButton.x / squareSize;
@@ -128,7 +147,11 @@ int main() {
                             auto moveIt = std::find(legalMoves.begin(), legalMoves.end(), std::make_pair(y, x));
                             if (moveIt != legalMoves.end()) {
                                 if (board.movePiece(selectedY, selectedX, y, x, currentPlayer)) {
-                                    currentPlayer = 'B';
+                                    // show a ascii version of the board on the terminal
+                                    board.display();
+                                    currentPlayer = (currentPlayer == 'W' ? 'B' : 'W');
+                                    std::tie(px, py) = {y, x};
+                                    std::tie(px1, py1) = {selectedY, selectedX};
                                 }
                             }
                             selectedX = selectedY = -1;
@@ -137,29 +160,60 @@ int main() {
                     }
                 }
             } else {
-                // computer's turn
+                // player vs computer Mode
+                if (currentPlayer == 'W') {
+                    if (event.type == sf::Event::MouseButtonPressed) {
+                        if (event.mouseButton.button == sf::Mouse::Left) {
+                            int x = event.mouseButton.x / squareSize;
+                            int y = event.mouseButton.y / squareSize;
+
+                            if (selectedX == -1 && selectedY == -1) {
+                                // selecting a piece
+                                selectedPiece = board.getPieceAt(y, x);
+                                if (selectedPiece && board.getPieceColor(y, x) == currentPlayer) {
+                                    selectedX = x;
+                                    selectedY = y;
+                                    legalMoves = board.getLegalMoves(y, x, currentPlayer);
+                                }
+                            } else {
+                                // moving a piece
+                                auto moveIt = std::find(legalMoves.begin(), legalMoves.end(), std::make_pair(y, x));
+                                if (moveIt != legalMoves.end()) {
+                                    if (board.movePiece(selectedY, selectedX, y, x, currentPlayer)) {
+                                        board.display();
+                                        currentPlayer = 'B';
+                                    }
+                                }
+                                selectedX = selectedY = -1;
+                                legalMoves.clear();
+                            }
+                        }
+                    }
+                } else {
+                    // computer's turn
 
-                // uncomment to see time per move
-                // auto timestart = std::chrono::high_resolution_clock::now();
+                    // uncomment to see time per move
+                    // auto timestart = std::chrono::high_resolution_clock::now();
 
-                auto [start, end] = engine.getBestMove(currentPlayer);
+                    auto [start, end] = engine.getBestMove(currentPlayer);
 
-                // auto timeend = std::chrono::high_resolution_clock::now();
-                // std::chrono::duration<double> elapsed = timeend - timestart;
-                // std::cout<< "Spent " << elapsed.count() << "s" << std::endl;
+                    // auto timeend = std::chrono::high_resolution_clock::now();
+                    // std::chrono::duration<double> elapsed = timeend - timestart;
+                    // std::cout<< "Spent " << elapsed.count() << "s" << std::endl;
 
-                std::tie(px, py) = start;
-                std::tie(px1, py1) = end;
-                if (start.first == -1) {
-                    std::cout << "Game over: no legal moves available.\n";
-                    window.close();
-                } else {
-                    if (board.movePiece(start.first, start.second, end.first, end.second, currentPlayer)) {
-                        currentPlayer = 'W';
+                    std::tie(px, py) = start;
+                    std::tie(px1, py1) = end;
+                    if (start.first == -1) {
+                        std::cout << "Game over: no legal moves available.\n";
+                        window.close();
+                    } else {
+                        if (board.movePiece(start.first, start.second, end.first, end.second, currentPlayer)) {
+                            board.display();
+                            currentPlayer = 'W';
+                        }
                     }
                 }
             }
-            #endif
         }
 
         window.clear();
@@ -233,5 +287,8 @@ int main() {
         // }
     }
 
+    if (!traceFile.empty() && !Trace::write(traceFile)) {
+        std::cerr << "Could not write " << traceFile << std::endl;
+    }
     return 0;
 }
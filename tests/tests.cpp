@@ -0,0 +1,329 @@
+// Checks of the engine's building blocks, built with -DBADFISH_TESTS=ON and
+// run by ctest. Each group is a ctest test of its own; the group named on
+// the command line runs, all of them without one.
+// usage: badfish-tests [perft | fen | packed | score | polyglot | eval]
+#include "Board.h"
+#include "Engine.h"
+#include "PackedPosition.h"
+#include "PawnHash.h"
+#include "Polyglot.h"
+#include "San.h"
+#include "Score.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define KIWIPETE_FEN "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
+
+// exit code ctest reports as a skipped test
+#define SKIPPED 77
+
+static int failures = 0;
+// a group that could not run what it checks, e.g. for lack of a data file
+static bool skipped = false;
+
+// reports a failed check with its line, the group carries on
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool passed, const char* what, int line) {
+    if (!passed) {
+        std::fprintf(stderr, "tests.cpp:%d: failed: %s\n", line, what);
+        failures++;
+    }
+}
+
+struct PerftCase {
+    const char* fen;
+    int depth;
+    long long nodes;
+    // captures on the last move, -1 when not checked
+    long long captures;
+};
+
+// the published counts, see the chessprogramming wiki's perft results
+static const PerftCase perftCases[] = {
+    {START_FEN, 1, 20, 0},
+    {START_FEN, 2, 400, 0},
+    {START_FEN, 3, 8902, 34},
+    {START_FEN, 4, 197281, 1576},
+    {KIWIPETE_FEN, 1, 48, 8},
+    {KIWIPETE_FEN, 2, 2039, 351},
+    {KIWIPETE_FEN, 3, 97862, 17102},
+    // en passant out of and into pins
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 43238, 3348},
+    // promotions, castling and checks
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467, 1021},
+    // a king checked by a pawn may not castle
+    {"4k3/8/8/8/8/8/3p4/4K2R w K - 0 1", 1, 5, -1},
+};
+
+static void testPerft() {
+    for (const PerftCase& test : perftCases) {
+        Board board;
+        CHECK(board.loadFromFEN(test.fen));
+        long long captures = 0;
+        long long nodes = board.perft(test.depth, board.getSideToMove(), captures);
+        if (nodes != test.nodes || (test.captures >= 0 && captures != test.captures)) {
+            std::fprintf(stderr, "perft %d of %s: %lld nodes, %lld captures, expected %lld, %lld\n",
+                         test.depth, test.fen, nodes, captures, test.nodes, test.captures);
+            failures++;
+        }
+    }
+}
+
+// FENs toFEN writes back unchanged
+static const char* roundTripFens[] = {
+    START_FEN,
+    KIWIPETE_FEN,
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    "rnbqkbnr/pppp1ppp/8/8/3Pp3/8/PPP1PPPP/RNBQKBNR b Kq d3 0 3",
+    "8/8/4k3/8/8/4K3/4P3/8 b - - 37 112",
+};
+
+static void testFen() {
+    for (const char* fen : roundTripFens) {
+        Board board;
+        CHECK(board.loadFromFEN(fen));
+        if (board.toFEN() != fen) {
+            std::fprintf(stderr, "toFEN wrote %s for %s\n", board.toFEN().c_str(), fen);
+            failures++;
+        }
+    }
+
+    // EPD lines without the move counters
+    Board board;
+    CHECK(board.loadFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"));
+    CHECK(board.toFEN() == START_FEN);
+    // rights the pieces do not allow are dropped
+    CHECK(board.loadFromFEN("4k3/8/8/8/8/8/8/4K2R w KQkq e6 0 1"));
+    CHECK(board.toFEN() == "4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+
+    const char* malformed[] = {
+        "",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkz - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 0",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 x",
+        // no black king, two white kings, a pawn on the last rank
+        "8/8/8/8/8/8/8/4K3 w - - 0 1",
+        "4k3/8/8/8/8/8/8/3KK3 w - - 0 1",
+        "P3k3/8/8/8/8/8/8/4K3 w - - 0 1",
+        // the side that just moved is in check
+        "k7/8/8/8/8/8/8/R3K3 w - - 0 1",
+    };
+    board.loadFromFEN(KIWIPETE_FEN);
+    for (const char* fen : malformed) {
+        if (board.loadFromFEN(fen)) {
+            std::fprintf(stderr, "loadFromFEN accepted \"%s\"\n", fen);
+            failures++;
+        }
+    }
+    // and the position before them is still there
+    CHECK(board.toFEN() == KIWIPETE_FEN);
+}
+
+static void testPacked() {
+    int score = -123;
+    for (const char* fen : roundTripFens) {
+        Board board;
+        CHECK(board.loadFromFEN(fen));
+        PackedPosition packed = packPosition(board, score, DRAW);
+        CHECK(packed.score == score);
+        CHECK(packed.result == DRAW);
+        CHECK(packed.sideToMove() == board.getSideToMove());
+        Board unpacked;
+        CHECK(unpacked.loadPacked(packed));
+        if (unpacked.toFEN() != fen) {
+            std::fprintf(stderr, "packed %s came back as %s\n", fen, unpacked.toFEN().c_str());
+            failures++;
+        }
+        score += 1000;
+    }
+
+    // records that are not positions are refused
+    Board board;
+    PackedPosition packed = packPosition(board);
+    CHECK(packed.score == PACKED_NO_SCORE);
+    CHECK(packed.result == NO_RESULT);
+    packed.enPassant = 9;
+    CHECK(!board.loadPacked(packed));
+    packed = packPosition(board);
+    packed.pieces[0] = (packed.pieces[0] & 0xF0) | 13;
+    CHECK(!board.loadPacked(packed));
+}
+
+static void testScore() {
+    const int values[] = {0, 1, -1, 100, -100, 12345, -12345, 32767, -32768};
+    for (int mg : values) {
+        for (int eg : values) {
+            Score score = makeScore(mg, eg);
+            CHECK(mgValue(score) == mg);
+            CHECK(egValue(score) == eg);
+        }
+    }
+    // packed scores add, subtract and scale like their halves
+    Score a = makeScore(30, -70), b = makeScore(-45, 20);
+    CHECK(a + b == makeScore(-15, -50));
+    CHECK(a - b == makeScore(75, -90));
+    CHECK(a * 3 == makeScore(90, -210));
+    CHECK(-a == makeScore(-30, 70));
+
+    CHECK(taper(makeScore(200, -40), MAX_PHASE) == 200);
+    CHECK(taper(makeScore(200, -40), 0) == -40);
+    CHECK(taper(makeScore(200, -40), MAX_PHASE / 2) == 80);
+    // a phase above the maximum, from promotions, counts as the maximum
+    CHECK(taper(makeScore(200, -40), MAX_PHASE + 6) == 200);
+}
+
+struct PolyglotCase {
+    const char* moves;
+    uint64_t key;
+};
+
+// the keys from Polyglot's book format description
+static const PolyglotCase polyglotCases[] = {
+    {"", POLYGLOT_START_KEY},
+    {"e2e4", 0x823C9B50FD114196ULL},
+    {"e2e4 d7d5", 0x0756B94461C50FB0ULL},
+    {"e2e4 d7d5 e4e5", 0x662FAFB965DB29D4ULL},
+    // f6 can be taken en passant, so the file counts
+    {"e2e4 d7d5 e4e5 f7f5", 0x22A48B5A8E47FF78ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2", 0x652A607CA3F242C1ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00FDD303C946BDD9ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4", 0x3C8123EA7B067637ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5C3F9B829B279560ULL},
+};
+
+static void testPolyglot() {
+    // a table that does not give the start key is refused
+    std::string badTable = "badfish-tests-random.txt";
+    {
+        std::ofstream out(badTable);
+        for (int i = 0; i < POLYGLOT_RANDOM_COUNT; i++) {
+            out << "0x" << std::hex << (i + 1) << ",\n";
+        }
+    }
+    CHECK(!loadPolyglotRandom(badTable));
+    CHECK(!polyglotRandomLoaded());
+    std::remove(badTable.c_str());
+
+    // castling is stored as the king taking its rook, and read back as the king's two-square move
+    Board board;
+    board.loadFromFEN(KIWIPETE_FEN);
+    BookMove castle = {{7, 4}, {7, 6}, 0, 0};
+    uint16_t encoded = encodePolyglotMove(castle, board);
+    CHECK(encoded == (7 | 0 << 3 | 4 << 6 | 0 << 9));
+    BookMove decoded = decodePolyglotMove(encoded, board);
+    CHECK(decoded.from == castle.from && decoded.to == castle.to && decoded.promotion == 0);
+
+#ifdef BOOK_RANDOM_FILE
+    if (!loadPolyglotRandom(BOOK_RANDOM_FILE)) {
+        std::fprintf(stderr, "could not load the Polyglot numbers from %s\n", BOOK_RANDOM_FILE);
+        failures++;
+        return;
+    }
+    for (const PolyglotCase& test : polyglotCases) {
+        board.loadFromFEN(START_FEN);
+        std::istringstream moves(test.moves);
+        std::string text;
+        SanMove move;
+        while (moves >> text) {
+            CHECK(parseCoordinateMove(text, move) &&
+                  board.movePiece(move.fromX, move.fromY, move.toX, move.toY, board.getSideToMove(), move.promotion));
+        }
+        uint64_t key = polyglotKey(board, board.getSideToMove());
+        if (key != test.key) {
+            std::fprintf(stderr, "Polyglot key after \"%s\" is %016llx, expected %016llx\n", test.moves,
+                         (unsigned long long)key, (unsigned long long)test.key);
+            failures++;
+        }
+    }
+#else
+    // the published numbers are not bundled, see Polyglot.h
+    std::fprintf(stderr, "no BOOK_RANDOM_FILE, Polyglot keys not checked\n");
+    skipped = true;
+#endif
+}
+
+// positions full of hanging pieces and attacks on bigger pieces, where the
+// terms the lazy exit skips swing the most
+static const char* tacticalFens[] = {
+    KIWIPETE_FEN,
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+    "r2q1rk1/ppp2ppp/2np1n2/2b1p1B1/2B1P1b1/2NP1N2/PPP2PPP/R2Q1RK1 w - - 0 8",
+    // queens and rooks attacked by pawns and minor pieces, some undefended
+    "k7/8/8/1q1q1q2/2P1P1P1/8/8/K7 w - - 0 1",
+    "1k6/8/2r1q1r1/1P1P1P1P/8/2N1N3/8/1K6 w - - 0 1",
+    "k7/q1q1q3/1P1P4/8/8/3p1p1p/2Q1Q1Q1/7K b - - 0 1",
+    "qqqqkqqq/8/8/8/8/2N2N2/PPPPPPPP/2B1KB2 w - - 0 1",
+    "4k3/8/8/3PPP2/2PqrqP1/3PPP2/8/4K3 w - - 0 1",
+};
+
+static void testEval() {
+    for (const char* fen : tacticalFens) {
+        Board board;
+        CHECK(board.loadFromFEN(fen));
+        // a fresh engine each time, so nothing comes from the cache
+        int full = Engine(board, 'W').evaluate(board);
+        // what the lazy exit looks at
+        PawnHashTable pawnTable;
+        int lazy = taper(board.psqScore + pawnTable.probe(board).score, board.gamePhase);
+        if (std::abs(full - lazy) > LAZY_EVAL_MARGIN) {
+            std::fprintf(stderr, "%s: full evaluation %d, lazy %d, more than %d apart\n",
+                         fen, full, lazy, LAZY_EVAL_MARGIN);
+            failures++;
+        }
+        // windows the lazy exit settles must get a bound on the right side
+        int above = lazy + LAZY_EVAL_MARGIN;
+        int upper = Engine(board, 'W').evaluate(board, above, above + 1);
+        CHECK(upper <= above && upper >= full);
+        int below = lazy - LAZY_EVAL_MARGIN;
+        int lower = Engine(board, 'W').evaluate(board, below - 1, below);
+        CHECK(lower >= below && lower <= full);
+    }
+}
+
+struct TestGroup {
+    const char* name;
+    void (*run)();
+};
+
+static const TestGroup groups[] = {
+    {"perft", testPerft},
+    {"fen", testFen},
+    {"packed", testPacked},
+    {"score", testScore},
+    {"polyglot", testPolyglot},
+    {"eval", testEval},
+};
+
+int main(int argc, char** argv) {
+    std::string only = (argc > 1) ? argv[1] : "";
+    bool found = false;
+    for (const TestGroup& group : groups) {
+        if (only.empty() || only == group.name) {
+            group.run();
+            found = true;
+        }
+    }
+    if (!found) {
+        std::fprintf(stderr, "usage: badfish-tests [perft | fen | packed | score | polyglot | eval]\n");
+        return 1;
+    }
+    if (failures) {
+        std::fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    // a skipped group only shows when it ran on its own, as under ctest
+    return (skipped && !only.empty()) ? SKIPPED : 0;
+}
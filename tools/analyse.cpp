@@ -0,0 +1,276 @@
+// Batch analysis: streams FEN or EPD lines from files or stdin, searches
+// each position on a pool of workers and writes one JSON object per line,
+// in input order. Every worker owns a Board and an Engine searching on a
+// single thread, so throughput grows with the number of workers.
+// usage: batch_analyse [-depth N | -nodes N] [-threads N] [-buffer N] [-o out.jsonl] [positions.epd...]
+#include "Board.h"
+#include "Engine.h"
+#include "San.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_DEPTH 4
+// positions read ahead of the oldest unwritten result
+#define DEFAULT_BUFFER 1024
+// each worker's eval cache, 8 MB per worker is plenty for short searches
+#define WORKER_HASH_MB 8
+
+struct Job {
+    uint64_t index;
+    std::string line;
+};
+
+// a position with the EPD operations that matter here
+struct Position {
+    std::string fen;
+    std::string id;
+    // SAN best and avoid moves, for puzzle checks
+    std::vector<std::string> bestMoves;
+    std::vector<std::string> avoidMoves;
+};
+
+static std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string jsonList(const std::vector<std::string>& items) {
+    std::string out = "[";
+    for (size_t i = 0; i < items.size(); i++) {
+        out += (i ? "," : "") + jsonString(items[i]);
+    }
+    return out + "]";
+}
+
+// FEN lines have move counters after the four position fields, EPD lines
+// have operations like "bm Nf3; id \"test 1\";" instead
+static bool parsePosition(const std::string& line, Position& position) {
+    std::istringstream in(line);
+    std::string fields[4];
+    for (std::string& field : fields) {
+        if (!(in >> field)) {
+            return false;
+        }
+    }
+    position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+    std::string rest;
+    std::getline(in >> std::ws, rest);
+    std::istringstream counters(rest);
+    int halfmove, fullmove;
+    if (counters >> halfmove >> fullmove) {
+        position.fen += " " + std::to_string(halfmove) + " " + std::to_string(fullmove);
+        return true;
+    }
+    position.fen += " 0 1";
+    // operations end in ';', quoted strings may contain anything else
+    std::string operation;
+    bool quoted = false;
+    for (char c : rest + ";") {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ';' && !quoted) {
+            std::istringstream words(operation);
+            std::string opcode, operand;
+            words >> opcode;
+            if (opcode == "id") {
+                std::getline(words >> std::ws, position.id);
+            }
+            while (words >> operand) {
+                if (opcode == "bm") position.bestMoves.push_back(operand);
+                if (opcode == "am") position.avoidMoves.push_back(operand);
+            }
+            operation.clear();
+        } else {
+            operation += c;
+        }
+    }
+    return true;
+}
+
+static std::string analyse(Board& board, Engine& engine, const SearchLimits& limits, const Job& job) {
+    std::string prefix = "{\"index\":" + std::to_string(job.index);
+    Position position;
+    if (!parsePosition(job.line, position)) {
+        return prefix + ",\"input\":" + jsonString(job.line) + ",\"error\":\"not a FEN or EPD line\"}";
+    }
+    prefix += ",\"fen\":" + jsonString(position.fen);
+    if (!position.id.empty()) {
+        prefix += ",\"id\":" + jsonString(position.id);
+    }
+    if (!board.loadFromFEN(position.fen)) {
+        return prefix + ",\"error\":\"invalid position\"}";
+    }
+    char side = board.getSideToMove();
+    SearchInfo info = engine.search(side, limits);
+    auto [from, to] = info.bestMove;
+    if (from.first < 0) {
+        return prefix + ",\"bestmove\":null,\"depth\":0,\"nodes\":0,\"time_ms\":0}";
+    }
+    std::string result = prefix + ",\"bestmove\":" +
+        jsonString(coordinateMove(board, from.first, from.second, to.first, to.second)) +
+        ",\"score\":" + std::to_string(side == 'W' ? info.score : -info.score) +
+        ",\"depth\":" + std::to_string(info.depth) + ",\"nodes\":" + std::to_string(info.nodes) +
+        ",\"time_ms\":" + std::to_string(info.time);
+    // an EPD puzzle is solved when the move is one of bm and none of am
+    if (!position.bestMoves.empty() || !position.avoidMoves.empty()) {
+        auto matches = [&](const std::vector<std::string>& moves) {
+            for (const std::string& san : moves) {
+                SanMove move;
+                if (parseSan(board, san, side, move) && move.fromX == from.first && move.fromY == from.second &&
+                    move.toX == to.first && move.toY == to.second) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        bool solved = (position.bestMoves.empty() || matches(position.bestMoves)) && !matches(position.avoidMoves);
+        if (!position.bestMoves.empty()) {
+            result += ",\"bm\":" + jsonList(position.bestMoves);
+        }
+        if (!position.avoidMoves.empty()) {
+            result += ",\"am\":" + jsonList(position.avoidMoves);
+        }
+        result += std::string(",\"solved\":") + (solved ? "true" : "false");
+    }
+    return result + "}";
+}
+
+int main(int argc, char** argv) {
+    SearchLimits limits;
+    limits.depth = DEFAULT_DEPTH;
+    int threadCount = std::max((int)std::thread::hardware_concurrency(), 1);
+    size_t bufferSize = DEFAULT_BUFFER;
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-depth" && i + 1 < argc) {
+            limits.depth = std::atoi(argv[++i]);
+        } else if (arg == "-nodes" && i + 1 < argc) {
+            limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+            limits.depth = 0;
+        } else if (arg == "-threads" && i + 1 < argc) {
+            threadCount = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-buffer" && i + 1 < argc) {
+            bufferSize = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg[0] == '-' && arg != "-") {
+            std::cerr << "usage: batch_analyse [-depth N | -nodes N] [-threads N] [-buffer N] [-o out.jsonl] [positions.epd...]" << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        inputs.push_back("-");
+    }
+    std::ofstream outputFile;
+    if (!output.empty()) {
+        outputFile.open(output);
+        if (!outputFile) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : outputFile;
+
+    // jobs wait in the queue, finished results in the reorder buffer until
+    // every earlier one is written; the reader stays at most bufferSize
+    // positions ahead of the writer, which bounds both
+    std::mutex mutex;
+    std::condition_variable jobReady, windowOpen;
+    std::deque<Job> jobs;
+    std::map<uint64_t, std::string> finished;
+    uint64_t nextIndex = 0, nextToWrite = 0;
+    bool inputDone = false;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&]() {
+            Board board;
+            Engine engine(board, 'W');
+            engine.setThreads(1);
+            engine.setHashSize(WORKER_HASH_MB);
+            while (true) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    jobReady.wait(lock, [&] { return !jobs.empty() || inputDone; });
+                    if (jobs.empty()) {
+                        return;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                std::string result = analyse(board, engine, limits, job);
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.emplace(job.index, std::move(result));
+                // whoever completes the oldest result writes out the run that follows
+                for (auto it = finished.find(nextToWrite); it != finished.end(); it = finished.find(nextToWrite)) {
+                    out << it->second << '\n';
+                    finished.erase(it);
+                    nextToWrite++;
+                }
+                out.flush();
+                windowOpen.notify_one();
+            }
+        });
+    }
+
+    for (const std::string& input : inputs) {
+        std::ifstream file;
+        if (input != "-") {
+            file.open(input);
+            if (!file) {
+                std::cerr << "Could not open " << input << std::endl;
+                continue;
+            }
+        }
+        std::istream& in = (input == "-") ? std::cin : file;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") == std::string::npos || line[0] == '#') {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            windowOpen.wait(lock, [&] { return nextIndex - nextToWrite < bufferSize; });
+            jobs.push_back({nextIndex++, line});
+            jobReady.notify_one();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inputDone = true;
+        jobReady.notify_all();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return 0;
+}
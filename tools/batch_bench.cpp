@@ -0,0 +1,63 @@
+// Throughput benchmark for PositionBatch: fills a batch with random
+// positions, checks the SIMD scores against the scalar path and the
+// incremental Board totals, then times both.
+// usage: batch_bench [positions]
+#include "BatchEval.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+int main(int argc, char** argv) {
+    size_t positions = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(12345);
+    PositionBatch batch;
+    std::vector<int> expected;
+    Board start;
+    start.initialise();
+    Board board = start;
+    for (size_t i = 0; i < positions; i++) {
+        // every position is the previous one with a random piece moved or removed
+        int from = rng() % 64;
+        int to = rng() % 64;
+        if (board.board[from / 8][from % 8] && !board.board[to / 8][to % 8] &&
+            board.board[from / 8][from % 8]->getPieceType() != KING) {
+            Piece* piece = board.takePiece(from / 8, from % 8);
+            if (rng() % 8 == 0) {
+                delete piece;
+            } else {
+                board.putPiece(to / 8, to % 8, piece);
+            }
+        }
+        if (rng() % 64 == 0) {
+            board = start;
+        }
+        batch.add(board);
+        expected.push_back(taper(board.psqScore, board.gamePhase));
+    }
+
+    std::vector<int> scalarScores, simdScores;
+    auto t0 = std::chrono::steady_clock::now();
+    batch.evaluateScalar(scalarScores);
+    auto t1 = std::chrono::steady_clock::now();
+    batch.evaluate(simdScores);
+    auto t2 = std::chrono::steady_clock::now();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < positions; i++) {
+        if (scalarScores[i] != expected[i] || simdScores[i] != expected[i]) {
+            if (mismatches++ < 10) {
+                std::cerr << "position " << i << ": board " << expected[i] << ", scalar "
+                          << scalarScores[i] << ", " << PositionBatch::simdName() << " " << simdScores[i] << std::endl;
+            }
+        }
+    }
+    double scalarSeconds = std::chrono::duration<double>(t1 - t0).count();
+    double simdSeconds = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "positions: " << positions << std::endl;
+    std::cout << "scalar: " << scalarSeconds << " s, " << positions / scalarSeconds / 1e6 << " M positions/s" << std::endl;
+    std::cout << PositionBatch::simdName() << ": " << simdSeconds << " s, "
+              << positions / simdSeconds / 1e6 << " M positions/s" << std::endl;
+    std::cout << "mismatches: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+// Generates the KQK, KRK and KPK bitbases by retrograde analysis on all
+// cores. KQK and KRK are solved first so KPK can look up its promotions.
+// usage: bitbase_gen [output directory] [threads]
+#include "Bitbase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+enum GenResult : uint8_t { UNKNOWN, DRAW, WIN, INVALID };
+
+struct Solver {
+    PieceType piece;
+    std::vector<std::atomic<uint8_t>> results;
+    // results of KQK and KRK, used for pawn promotions
+    const Solver* queen = nullptr;
+    const Solver* rook = nullptr;
+
+    explicit Solver(PieceType piece) : piece(piece), results(BITBASE_POSITIONS) {}
+
+    uint8_t get(int index) const {
+        return results[index].load(std::memory_order_relaxed);
+    }
+
+    // squares attacked by the strong side's piece, white pawns move towards row 0
+    Bitboard pieceAttacks(int square, Bitboard occupied) const {
+        switch (piece) {
+            case PAWN: return attackTables.pawn[0][square];
+            case ROOK: return rookAttacks(square, occupied);
+            default: return queenAttacks(square, occupied);
+        }
+    }
+
+    bool isValid(int strongToMove, int strongKing, int weakKing, int square) const {
+        if (strongKing == weakKing || strongKing == square || weakKing == square) {
+            return false;
+        }
+        if (attackTables.king[strongKing] & (1ULL << weakKing)) {
+            return false;
+        }
+        if (piece == PAWN && (square / 8 == 0 || square / 8 == 7)) {
+            return false;
+        }
+        // the weak side cannot have left its king in check
+        Bitboard occupied = (1ULL << strongKing) | (1ULL << weakKing) | (1ULL << square);
+        return !(strongToMove && (pieceAttacks(square, occupied) & (1ULL << weakKing)));
+    }
+
+    // the strong side wins if any move wins, draws if every move draws
+    uint8_t solveStrong(int strongKing, int weakKing, int square) const {
+        Bitboard occupied = (1ULL << strongKing) | (1ULL << weakKing) | (1ULL << square);
+        bool unknown = false;
+        auto visit = [&](uint8_t result) {
+            if (result == WIN) {
+                return true;
+            }
+            unknown |= (result == UNKNOWN);
+            return false;
+        };
+
+        Bitboard kingMoves = attackTables.king[strongKing] & ~attackTables.king[weakKing] & ~occupied;
+        while (kingMoves) {
+            if (visit(get(bitbaseIndex(0, popLsb(kingMoves), weakKing, square)))) {
+                return WIN;
+            }
+        }
+        if (piece == PAWN) {
+            int push = square - 8;
+            if (!(occupied & (1ULL << push))) {
+                if (push / 8 == 0) {
+                    // promote, the rook only matters where the queen would stalemate
+                    if (visit(queen->get(bitbaseIndex(0, strongKing, weakKing, push))) ||
+                        visit(rook->get(bitbaseIndex(0, strongKing, weakKing, push)))) {
+                        return WIN;
+                    }
+                } else {
+                    if (visit(get(bitbaseIndex(0, strongKing, weakKing, push)))) {
+                        return WIN;
+                    }
+                    int doublePush = push - 8;
+                    if (square / 8 == 6 && !(occupied & (1ULL << doublePush)) &&
+                        visit(get(bitbaseIndex(0, strongKing, weakKing, doublePush)))) {
+                        return WIN;
+                    }
+                }
+            }
+        } else {
+            Bitboard moves = pieceAttacks(square, occupied) & ~occupied;
+            while (moves) {
+                if (visit(get(bitbaseIndex(0, strongKing, weakKing, popLsb(moves))))) {
+                    return WIN;
+                }
+            }
+        }
+        return unknown ? UNKNOWN : DRAW;
+    }
+
+    // the weak side draws if any move draws, loses if every move loses
+    uint8_t solveWeak(int strongKing, int weakKing, int square) const {
+        Bitboard occupied = (1ULL << strongKing) | (1ULL << weakKing) | (1ULL << square);
+        // attacks through the weak king's square, it cannot hide behind itself
+        Bitboard attacked = pieceAttacks(square, occupied & ~(1ULL << weakKing)) | attackTables.king[strongKing];
+        Bitboard kingMoves = attackTables.king[weakKing] & ~attacked & ~(1ULL << strongKing);
+        if (!kingMoves) {
+            bool inCheck = pieceAttacks(square, occupied) & (1ULL << weakKing);
+            return inCheck ? WIN : DRAW;
+        }
+        bool unknown = false;
+        while (kingMoves) {
+            int to = popLsb(kingMoves);
+            if (to == square) {
+                // the piece is undefended, only bare kings are left
+                return DRAW;
+            }
+            uint8_t result = get(bitbaseIndex(1, strongKing, to, square));
+            if (result == DRAW) {
+                return DRAW;
+            }
+            unknown |= (result == UNKNOWN);
+        }
+        return unknown ? UNKNOWN : WIN;
+    }
+
+    // one pass over a range of positions, returns whether anything was resolved
+    bool pass(int begin, int end) {
+        bool changed = false;
+        for (int index = begin; index < end; index++) {
+            if (get(index) != UNKNOWN) {
+                continue;
+            }
+            int square = index % 64;
+            int weakKing = index / 64 % 64;
+            int strongKing = index / (64 * 64) % 64;
+            int strongToMove = index / (64 * 64 * 64);
+            uint8_t result;
+            if (!isValid(strongToMove, strongKing, weakKing, square)) {
+                result = INVALID;
+            } else if (strongToMove) {
+                result = solveStrong(strongKing, weakKing, square);
+            } else {
+                result = solveWeak(strongKing, weakKing, square);
+            }
+            if (result != UNKNOWN) {
+                results[index].store(result, std::memory_order_relaxed);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    // results only ever go from UNKNOWN to final, so threads may read each
+    // other's partly updated passes; a stale read only delays convergence
+    int solve(int threadCount) {
+        int passes = 0;
+        std::atomic<bool> changed{true};
+        while (changed) {
+            changed = false;
+            passes++;
+            std::vector<std::thread> threads;
+            int chunk = (BITBASE_POSITIONS + threadCount - 1) / threadCount;
+            for (int t = 0; t < threadCount; t++) {
+                int begin = t * chunk;
+                int end = std::min(begin + chunk, BITBASE_POSITIONS);
+                threads.emplace_back([this, begin, end, &changed]() {
+                    if (pass(begin, end)) {
+                        changed = true;
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+        // positions never resolved can be held forever
+        for (auto& result : results) {
+            if (result == UNKNOWN) {
+                result = DRAW;
+            }
+        }
+        return passes;
+    }
+
+    bool write(const std::string& path) const {
+        std::vector<uint8_t> bits(BITBASE_POSITIONS / 8, 0);
+        for (int index = 0; index < BITBASE_POSITIONS; index++) {
+            if (get(index) == WIN) {
+                bits[index >> 3] |= 1 << (index & 7);
+            }
+        }
+        std::ofstream out(path, std::ios::binary);
+        uint32_t version = 1;
+        out.write("BFBB", 4);
+        out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        out.write(reinterpret_cast<const char*>(bits.data()), bits.size());
+        return bool(out);
+    }
+};
+
+int main(int argc, char** argv) {
+    std::string directory = (argc > 1) ? argv[1] : ".";
+    int threadCount = (argc > 2) ? std::atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    threadCount = std::max(threadCount, 1);
+
+    Solver queen(QUEEN), rook(ROOK), pawn(PAWN);
+    pawn.queen = &queen;
+    pawn.rook = &rook;
+    const std::pair<Solver*, const char*> tables[] = {{&queen, "kqk.bb"}, {&rook, "krk.bb"}, {&pawn, "kpk.bb"}};
+    for (const auto& [solver, name] : tables) {
+        auto start = std::chrono::steady_clock::now();
+        int passes = solver->solve(threadCount);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int wins = 0, draws = 0;
+        for (int index = 0; index < BITBASE_POSITIONS; index++) {
+            wins += solver->get(index) == WIN;
+            draws += solver->get(index) == DRAW;
+        }
+        std::string path = directory + "/" + name;
+        if (!solver->write(path)) {
+            std::cerr << "Could not write " << path << std::endl;
+            return 1;
+        }
+        std::cout << name << ": " << wins << " wins, " << draws << " draws, " << passes << " passes, "
+                  << seconds << " s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,399 @@
+// Builds a Polyglot opening book from PGN files. Games are streamed from
+// disk, replayed on Board by worker threads and counted per (position,
+// move) in a sharded hash map; the result is written sorted by key.
+// Keys need Polyglot's published random numbers, from -random or the
+// BOOK_RANDOM_FILE the engine is built with (see Polyglot.h).
+// usage: book_build [-ply N] [-min-games N] [-max-entries N] [-threads N]
+//                   [-random random64.txt] -o book.bin games.pgn...
+#include "Polyglot.h"
+#include "San.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+// games parsed ahead of the workers, bounds the memory used by the reader
+#define GAME_QUEUE_SIZE 4096
+// must be a power of two
+#define SHARD_COUNT 64
+
+struct PgnGame {
+    std::vector<std::string> moves;
+    // white's result in half points: 2 win, 1 draw, 0 loss, -1 unknown
+    int whitePoints = -1;
+    // started from a set-up position, which the book does not cover
+    bool customStart = false;
+};
+
+// splits a PGN stream into games, keeping only the first maxPly moves of
+// each; comments, variations, NAGs and move numbers are dropped
+class PgnReader {
+private:
+    std::istream& in;
+    size_t maxPly;
+    int commentDepth = 0;
+    int variationDepth = 0;
+public:
+    PgnReader(std::istream& in, size_t maxPly) : in(in), maxPly(maxPly) {}
+
+    bool next(PgnGame& game) {
+        game = PgnGame();
+        bool started = false;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (commentDepth == 0 && variationDepth == 0 && !line.empty() && line[0] == '[') {
+                started = true;
+                if (line.compare(0, 5, "[FEN ") == 0) {
+                    game.customStart = true;
+                }
+                if (line.compare(0, 8, "[Result ") == 0) {
+                    game.whitePoints = parseResult(line.substr(9, line.find('"', 9) - 9));
+                }
+                continue;
+            }
+            if (readMoves(line, game, started)) {
+                return true;
+            }
+        }
+        // a last game without a result token
+        return started && !game.moves.empty();
+    }
+
+private:
+    static int parseResult(const std::string& result) {
+        if (result == "1-0") return 2;
+        if (result == "0-1") return 0;
+        if (result == "1/2-1/2") return 1;
+        return -1;
+    }
+
+    // returns true at the result token that ends the game
+    bool readMoves(const std::string& line, PgnGame& game, bool& started) {
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (commentDepth > 0) {
+                if (c == '}') {
+                    commentDepth = 0;
+                }
+                i++;
+            } else if (c == '{') {
+                commentDepth = 1;
+                i++;
+            } else if (c == ';') {
+                return false;
+            } else if (c == '(') {
+                variationDepth++;
+                i++;
+            } else if (c == ')') {
+                variationDepth = std::max(variationDepth - 1, 0);
+                i++;
+            } else if (std::isspace((unsigned char)c)) {
+                i++;
+            } else {
+                size_t end = i;
+                while (end < line.size() && !std::isspace((unsigned char)line[end]) &&
+                       !std::strchr("{}();", line[end])) {
+                    end++;
+                }
+                std::string token = line.substr(i, end - i);
+                i = end;
+                if (variationDepth > 0) {
+                    continue;
+                }
+                started = true;
+                if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                    if (game.whitePoints < 0) {
+                        game.whitePoints = parseResult(token);
+                    }
+                    return true;
+                }
+                // move numbers may be glued to the move, as in "12.e4" or "12...Nf6"
+                size_t digits = 0;
+                while (digits < token.size() && std::isdigit((unsigned char)token[digits])) {
+                    digits++;
+                }
+                if (digits > 0 && digits < token.size() && token[digits] == '.') {
+                    token.erase(0, token.find_first_not_of('.', digits));
+                }
+                if (token.empty() || token[0] == '$' || std::isdigit((unsigned char)token[0])) {
+                    continue;
+                }
+                if (game.moves.size() < maxPly) {
+                    game.moves.push_back(token);
+                }
+            }
+        }
+        return false;
+    }
+};
+
+struct EntryKey {
+    uint64_t key;
+    uint16_t move;
+    bool operator==(const EntryKey& other) const {
+        return key == other.key && move == other.move;
+    }
+};
+
+struct EntryKeyHash {
+    size_t operator()(const EntryKey& entry) const {
+        return (size_t)(entry.key ^ (entry.move * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+struct MoveStats {
+    uint32_t games = 0;
+    // half points scored by the side that played the move
+    uint32_t points = 0;
+};
+
+// (position, move) statistics split over independently locked shards so
+// workers rarely wait on each other. When a shard outgrows its share of
+// maxEntries, the rarest moves are dropped, which keeps memory bounded
+// on archives of any size.
+class ShardedStats {
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<EntryKey, MoveStats, EntryKeyHash> entries;
+    };
+    Shard shards[SHARD_COUNT];
+    size_t shardLimit;
+    std::atomic<uint64_t> prunedEntries{0};
+
+    void prune(Shard& shard) {
+        size_t target = shardLimit * 3 / 4;
+        for (uint32_t threshold = 1; shard.entries.size() > target; threshold++) {
+            for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+                if (it->second.games <= threshold) {
+                    it = shard.entries.erase(it);
+                    prunedEntries++;
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+public:
+    explicit ShardedStats(size_t maxEntries) : shardLimit(std::max(maxEntries / SHARD_COUNT, size_t(16))) {}
+
+    void add(uint64_t key, uint16_t move, uint32_t points) {
+        Shard& shard = shards[key & (SHARD_COUNT - 1)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        MoveStats& stats = shard.entries[{key, move}];
+        stats.games++;
+        stats.points += points;
+        if (shard.entries.size() > shardLimit) {
+            prune(shard);
+        }
+    }
+
+    uint64_t getPrunedEntries() const {
+        return prunedEntries;
+    }
+
+    // only called once the workers are done
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Shard& shard : shards) {
+            for (const auto& [entry, stats] : shard.entries) {
+                visit(entry, stats);
+            }
+        }
+    }
+};
+
+// hands games from the reader to the workers, blocking the reader when full
+class GameQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<PgnGame> games;
+    bool closed = false;
+public:
+    void push(PgnGame&& game) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return games.size() < GAME_QUEUE_SIZE; });
+        games.push_back(std::move(game));
+        notEmpty.notify_one();
+    }
+
+    bool pop(PgnGame& game) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !games.empty() || closed; });
+        if (games.empty()) {
+            return false;
+        }
+        game = std::move(games.front());
+        games.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+static void writeBigEndian(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t maxPly = 20;
+    uint32_t minGames = 1;
+    size_t maxEntries = 50000000;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    std::string output;
+#ifdef BOOK_RANDOM_FILE
+    std::string randomFile = BOOK_RANDOM_FILE;
+#else
+    std::string randomFile;
+#endif
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-ply" && i + 1 < argc) {
+            maxPly = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-min-games" && i + 1 < argc) {
+            minGames = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-max-entries" && i + 1 < argc) {
+            maxEntries = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-threads" && i + 1 < argc) {
+            threadCount = std::atoi(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "-random" && i + 1 < argc) {
+            randomFile = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (output.empty() || inputs.empty()) {
+        std::cerr << "usage: book_build [-ply N] [-min-games N] [-max-entries N] [-threads N]\n"
+                     "                  [-random random64.txt] -o book.bin games.pgn..." << std::endl;
+        return 1;
+    }
+    // keys from any other table would match no book reader, ours included
+    if (randomFile.empty()) {
+        std::cerr << "Polyglot's random numbers are needed, pass -random or build with BOOK_RANDOM_FILE" << std::endl;
+        return 1;
+    }
+    if (!loadPolyglotRandom(randomFile)) {
+        std::cerr << "Could not read Polyglot random numbers from " << randomFile << std::endl;
+        return 1;
+    }
+    threadCount = std::max(threadCount, 1);
+
+    Board startBoard;
+    startBoard.loadFromFEN(START_FEN);
+    ShardedStats stats(maxEntries);
+    GameQueue queue;
+    std::atomic<uint64_t> gamesUsed{0}, gamesSkipped{0}, badMoves{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&]() {
+            PgnGame game;
+            while (queue.pop(game)) {
+                if (game.customStart || game.whitePoints < 0) {
+                    gamesSkipped++;
+                    continue;
+                }
+                Board board = startBoard;
+                char side = 'W';
+                for (const std::string& san : game.moves) {
+                    SanMove move;
+                    if (!parseSan(board, san, side, move)) {
+                        badMoves++;
+                        break;
+                    }
+                    BookMove bookMove = {{move.fromX, move.fromY}, {move.toX, move.toY}, 0, 0};
+                    Piece* piece = board.board[move.fromX][move.fromY];
+                    if (piece->getPieceType() == PAWN && (move.toX == 0 || move.toX == 7)) {
+                        bookMove.promotion = move.promotion;
+                    }
+                    uint32_t points = (side == 'W') ? game.whitePoints : 2 - game.whitePoints;
+                    stats.add(polyglotKey(board, side), encodePolyglotMove(bookMove, board), points);
+                    board.movePiece(move.fromX, move.fromY, move.toX, move.toY, side, move.promotion);
+                    side = (side == 'W') ? 'B' : 'W';
+                }
+                gamesUsed++;
+            }
+        });
+    }
+
+    for (const std::string& input : inputs) {
+        std::ifstream in(input);
+        if (!in) {
+            std::cerr << "Could not open " << input << std::endl;
+            continue;
+        }
+        PgnReader reader(in, maxPly);
+        PgnGame game;
+        while (reader.next(game)) {
+            queue.push(std::move(game));
+        }
+    }
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // weight is the half points scored with the move, scaled down if needed
+    struct BookEntry {
+        uint64_t key;
+        uint16_t move;
+        uint32_t weight;
+    };
+    std::vector<BookEntry> entries;
+    uint32_t maxWeight = 0;
+    stats.forEach([&](const EntryKey& entry, const MoveStats& moveStats) {
+        if (moveStats.games >= minGames && moveStats.points > 0) {
+            entries.push_back({entry.key, entry.move, moveStats.points});
+            maxWeight = std::max(maxWeight, moveStats.points);
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) {
+        return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+    });
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(entries.size() * 16);
+    for (const BookEntry& entry : entries) {
+        uint32_t weight = (maxWeight > 0xFFFF) ? (uint32_t)((uint64_t)entry.weight * 0xFFFF / maxWeight) : entry.weight;
+        writeBigEndian(bytes, entry.key, 8);
+        writeBigEndian(bytes, entry.move, 2);
+        writeBigEndian(bytes, std::max(weight, 1u), 2);
+        writeBigEndian(bytes, 0, 4);
+    }
+    std::ofstream out(output, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    if (!out) {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "games: " << gamesUsed << " used, " << gamesSkipped << " skipped, "
+              << badMoves << " stopped at an unreadable move" << std::endl;
+    std::cout << "entries: " << entries.size() << " written, " << stats.getPrunedEntries()
+              << " pruned to bound memory" << std::endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Terminal front end: play against the engine, or let it play itself,
+// without the SFML board. Moves are typed in SAN ("Nf3") or coordinates
+// ("g1f3"); "go" makes the engine move for the side to move. "bench"
+// searches a fixed set of positions and reports nodes and speed.
+// -trace writes a timeline of the searches, see Trace.h; -tree writes the
+// tree of the last search, see SearchTree.h, for tree_query.
+// usage: badfish [-fen FEN] [-computer white|black|both|none] [-depth N] [-movetime MS] [-trace FILE]
+//                [-tree FILE [-tree-nodes N] [-tree-move MOVE]]
+//        badfish bench [depth] [json]
+#include "Bench.h"
+#include "Board.h"
+#include "Engine.h"
+#include "Bitbase.h"
+#include "San.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+// plies, the same as the GUI's fixed depth
+#define DEFAULT_DEPTH 3
+// nodes a search tree file holds at most, 32 bytes each
+#define DEFAULT_TREE_NODES 1000000
+
+static bool hasLegalMove(Board& board, char side) {
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board.board[row][col];
+            if (piece && piece->getColor() == side && !board.getLegalMoves(row, col, side).empty()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    std::string fen = START_FEN;
+    // which sides the engine plays
+    bool computer[2] = {false, true};
+    std::string traceFile;
+    std::string treeFile, treeMove;
+    size_t treeNodes = DEFAULT_TREE_NODES;
+    SearchLimits limits;
+    limits.depth = DEFAULT_DEPTH;
+    bool bench = argc > 1 && std::string(argv[1]) == "bench";
+    int benchDepth;
+    bool benchJson;
+    if (bench && !parseBenchArguments(std::vector<std::string>(argv + 2, argv + argc), benchDepth, benchJson)) {
+        std::cerr << "usage: badfish bench [depth] [json]" << std::endl;
+        return 1;
+    }
+    for (int i = 1; i < argc && !bench; i++) {
+        std::string arg = argv[i];
+        if (arg == "-fen" && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (arg == "-computer" && i + 1 < argc) {
+            std::string sides = argv[++i];
+            computer[0] = (sides == "white" || sides == "both");
+            computer[1] = (sides == "black" || sides == "both");
+        } else if (arg == "-depth" && i + 1 < argc) {
+            limits.depth = std::atoi(argv[++i]);
+        } else if (arg == "-trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg == "-tree" && i + 1 < argc) {
+            treeFile = argv[++i];
+        } else if (arg == "-tree-nodes" && i + 1 < argc) {
+            treeNodes = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "-tree-move" && i + 1 < argc) {
+            treeMove = argv[++i];
+        } else if (arg == "-movetime" && i + 1 < argc) {
+            limits.moveTime = std::atoll(argv[++i]);
+            limits.depth = 0;
+        } else {
+            std::cerr << "usage: badfish [-fen FEN] [-computer white|black|both|none] [-depth N] [-movetime MS] [-trace FILE]\n"
+                         "               [-tree FILE [-tree-nodes N] [-tree-move MOVE]]\n"
+                         "       badfish bench [depth] [json]" << std::endl;
+            return 1;
+        }
+    }
+
+#ifdef BITBASE_DIR
+    std::cout << "Loaded " << loadBitbases(BITBASE_DIR) << " endgame bitbases" << std::endl;
+#endif
+#ifdef BOOK_RANDOM_FILE
+    if (!loadPolyglotRandom(BOOK_RANDOM_FILE)) {
+        std::cerr << "Could not read Polyglot random numbers from " << BOOK_RANDOM_FILE << std::endl;
+    }
+#endif
+    Board board;
+    Engine engine(board, 'B');
+#ifdef BOOK_FILE
+    PolyglotBook book;
+    if (book.open(BOOK_FILE)) {
+        engine.setBook(&book);
+    } else {
+        std::cerr << "Could not open " << BOOK_FILE
+                  << (polyglotRandomLoaded() ? "" : ", it needs the Polyglot random numbers from BOOK_RANDOM_FILE") << std::endl;
+    }
+#endif
+#ifdef NNUE_FILE
+    if (Nnue::load(NNUE_FILE)) {
+        engine.setUseNnue(true);
+    } else {
+        std::cerr << "Could not load " << NNUE_FILE << ", using the classic evaluator" << std::endl;
+    }
+#endif
+    if (bench) {
+        printBench(runBench(benchDepth, &std::cerr), std::cout, benchJson);
+        return 0;
+    }
+    if (!board.loadFromFEN(fen)) {
+        std::cerr << "Invalid FEN: " << fen << std::endl;
+        return 1;
+    }
+    std::string lastMove;
+    std::unique_ptr<SearchTreeRecorder> treeRecorder;
+    if (!treeFile.empty()) {
+        treeRecorder = std::make_unique<SearchTreeRecorder>(treeNodes);
+        SanMove move;
+        if (!treeMove.empty()) {
+            if (!parseCoordinateMove(treeMove, move)) {
+                std::cerr << "Invalid move for -tree-move: " << treeMove << std::endl;
+                return 1;
+            }
+            treeRecorder->setSubtree(move.fromX * 8 + move.fromY, move.toX * 8 + move.toY);
+        }
+        engine.setTreeRecorder(treeRecorder.get());
+    }
+    if (!traceFile.empty()) {
+        Trace::setThreadName("main");
+        Trace::start();
+    }
+
+    while (true) {
+        char side = board.getSideToMove();
+        board.display();
+        if (!lastMove.empty()) {
+            std::cout << lastMove << std::endl;
+        }
+        if (!hasLegalMove(board, side)) {
+            std::cout << "Game over: no legal moves for " << (side == 'W' ? "white" : "black") << std::endl;
+            return 0;
+        }
+        std::string input = "go";
+        if (!computer[colorIndex(side)]) {
+            std::cout << (side == 'W' ? "White" : "Black") << " to move> " << std::flush;
+            if (!std::getline(std::cin, input) || input == "quit") {
+                return 0;
+            }
+        }
+        if (input.compare(0, 4, "fen ") == 0) {
+            lastMove = board.loadFromFEN(input.substr(4)) ? "" : "Invalid FEN, the position is unchanged";
+            continue;
+        }
+        SanMove move;
+        if (input == "go") {
+            if (treeRecorder) {
+                treeRecorder->clear();
+            }
+            SearchInfo info = engine.search(side, limits);
+            auto [from, to] = info.bestMove;
+            move = {from.first, from.second, to.first, to.second, QUEEN};
+            int score = (side == 'W') ? info.score : -info.score;
+            lastMove = "BadFish plays " + coordinateMove(board, from.first, from.second, to.first, to.second) +
+                " (depth " + std::to_string(info.depth) + ", score " + std::to_string(score) +
+                ", " + std::to_string(info.nodes) + " nodes, " + std::to_string(info.time) + " ms)";
+            // rewritten after every search, so quitting any way leaves a complete file
+            if (!traceFile.empty() && !Trace::write(traceFile)) {
+                lastMove += ", could not write " + traceFile;
+            }
+            if (treeRecorder) {
+                lastMove += treeRecorder->write(treeFile) ? ", " + std::to_string(treeRecorder->size()) +
+                    " tree nodes" + (treeRecorder->isFull() ? " (full)" : "") : ", could not write " + treeFile;
+            }
+        } else if (parseSan(board, input, side, move) || parseCoordinateMove(input, move)) {
+            lastMove = "You played " + input;
+        } else {
+            lastMove = "Could not read \"" + input + "\", type a move like Nf3 or g1f3, go, fen <FEN> or quit";
+            continue;
+        }
+        if (!board.movePiece(move.fromX, move.fromY, move.toX, move.toY, side, move.promotion)) {
+            lastMove = input + " is not a legal move";
+        }
+    }
+}
@@ -0,0 +1,623 @@
+// Engine-vs-engine matches between two UCI engines, e.g. two builds of
+// badfish-uci or one build with different options. Each opening is played
+// twice with colours swapped, several games at a time, each game worker
+// running its own pair of engine processes. Games are refereed on Board;
+// results are reported as Elo with a 95% interval, and with -sprt the match
+// stops once the sequential probability ratio test accepts either
+// hypothesis.
+// usage: match -engine cmd=PATH [name=NAME] [option.NAME=VALUE]...
+//              -engine cmd=PATH [name=NAME] [option.NAME=VALUE]...
+//              [-nodes N | -movetime MS | -tc SECONDS[+INCREMENT]]
+//              [-openings FILE] [-games N] [-concurrency N]
+//              [-sprt elo0=0 elo1=5 alpha=0.05 beta=0.05]
+//              [-resign SCORE MOVES] [-draw PLY SCORE MOVES] [-max-plies N]
+#include "Board.h"
+#include "Polyglot.h"
+#include "San.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+int main() {
+    std::cerr << "match needs POSIX pipes and is not available on Windows" << std::endl;
+    return 1;
+}
+#else
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+// how long an engine may take beyond its time before it forfeits, and how
+// long it may take for anything without a clock
+#define TIME_MARGIN_MS 1000
+#define NO_CLOCK_TIMEOUT_MS 60000
+// reported as a score in centipawns, well above anything the evaluation gives
+#define MATE_CP 100000
+
+// an engine process speaking UCI over a pair of pipes
+class UciProcess {
+private:
+    pid_t pid = -1;
+    int toEngine = -1;
+    int fromEngine = -1;
+    std::string pending;
+public:
+    UciProcess() = default;
+    UciProcess(const UciProcess&) = delete;
+    UciProcess& operator=(const UciProcess&) = delete;
+
+    // runs the command through /bin/sh, so it may carry arguments
+    bool start(const std::string& command) {
+        int in[2], out[2];
+        if (pipe(in) != 0) {
+            return false;
+        }
+        if (pipe(out) != 0) {
+            close(in[0]);
+            close(in[1]);
+            return false;
+        }
+        pid = fork();
+        if (pid == 0) {
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            close(in[0]);
+            close(in[1]);
+            close(out[0]);
+            close(out[1]);
+            execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+        close(in[0]);
+        close(out[1]);
+        if (pid < 0) {
+            close(in[1]);
+            close(out[0]);
+            return false;
+        }
+        toEngine = in[1];
+        fromEngine = out[0];
+        return true;
+    }
+
+    void send(const std::string& line) {
+        std::string text = line + "\n";
+        for (size_t written = 0; written < text.size();) {
+            ssize_t n = write(toEngine, text.data() + written, text.size() - written);
+            if (n <= 0) {
+                return;
+            }
+            written += n;
+        }
+    }
+
+    // false when the engine exits or stays silent for timeoutMs
+    bool readLine(std::string& line, int64_t timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            size_t newline = pending.find('\n');
+            if (newline != std::string::npos) {
+                line = pending.substr(0, newline);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                pending.erase(0, newline + 1);
+                return true;
+            }
+            int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            pollfd fd = {fromEngine, POLLIN, 0};
+            if (left <= 0 || poll(&fd, 1, (int)std::min<int64_t>(left, 1000000)) <= 0) {
+                return false;
+            }
+            char buffer[4096];
+            ssize_t n = read(fromEngine, buffer, sizeof(buffer));
+            if (n <= 0) {
+                return false;
+            }
+            pending.append(buffer, n);
+        }
+    }
+
+    // reads until a line starting with token
+    bool waitFor(const std::string& token, int64_t timeoutMs) {
+        std::string line;
+        while (readLine(line, timeoutMs)) {
+            if (line.compare(0, token.size(), token) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ~UciProcess() {
+        if (pid > 0) {
+            send("quit");
+            close(toEngine);
+            close(fromEngine);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+};
+
+struct EngineConfig {
+    std::string command;
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> options;
+};
+
+struct MatchSettings {
+    EngineConfig engines[2];
+    uint64_t nodes = 0;
+    int64_t moveTime = 0;
+    int64_t baseTime = 0;
+    int64_t increment = 0;
+    std::vector<std::string> openings;
+    int games = 0;
+    int concurrency = 1;
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+    // a side resigns after resignMoves of its own moves at or below -resignScore,
+    // confirmed by the opponent's score
+    int resignScore = 1000;
+    int resignMoves = 3;
+    // a draw once both report within drawScore for drawMoves moves each after drawPly
+    int drawPly = 80;
+    int drawScore = 10;
+    int drawMoves = 8;
+    int maxPlies = 600;
+};
+
+// results from the first engine's point of view
+struct MatchStats {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const {
+        return wins + draws + losses;
+    }
+    double score() const {
+        return games() ? (wins + draws * 0.5) / games() : 0.5;
+    }
+    // variance of a single game's score
+    double variance() const {
+        double s = score();
+        return games() ? (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games() : 0;
+    }
+};
+
+static double eloFromScore(double score) {
+    score = std::clamp(score, 1e-6, 1 - 1e-6);
+    return -400 * std::log10(1 / score - 1);
+}
+
+static double scoreFromElo(double elo) {
+    return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// log likelihood ratio of elo1 against elo0, with the game scores taken
+// as normally distributed
+static double logLikelihoodRatio(const MatchStats& stats, double elo0, double elo1) {
+    double variance = stats.variance();
+    if (stats.games() == 0 || variance <= 0) {
+        return 0;
+    }
+    double s0 = scoreFromElo(elo0), s1 = scoreFromElo(elo1);
+    return stats.games() * (s1 - s0) * (2 * stats.score() - s0 - s1) / (2 * variance);
+}
+
+static bool inCheck(const Board& board, char side) {
+    int us = colorIndex(side), them = us ^ 1;
+    Bitboard occupied = board.colorBitboards[0] | board.colorBitboards[1];
+    int kingSquare = lsb(board.pieceBitboards[us][KING]);
+    const Bitboard (&attackers)[6] = board.pieceBitboards[them];
+    return (attackTables.pawn[us][kingSquare] & attackers[PAWN]) ||
+        (attackTables.knight[kingSquare] & attackers[KNIGHT]) ||
+        (attackTables.king[kingSquare] & attackers[KING]) ||
+        (bishopAttacks(kingSquare, occupied) & (attackers[BISHOP] | attackers[QUEEN])) ||
+        (rookAttacks(kingSquare, occupied) & (attackers[ROOK] | attackers[QUEEN]));
+}
+
+static bool hasLegalMove(Board& board, char side) {
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board.board[row][col];
+            if (piece && piece->getColor() == side && !board.getLegalMoves(row, col, side).empty()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// bare kings, or a single minor piece against a bare king
+static bool insufficientMaterial(const Board& board) {
+    Bitboard others = board.colorBitboards[0] | board.colorBitboards[1];
+    for (int c = 0; c < 2; c++) {
+        others &= ~(board.pieceBitboards[c][KING] | board.pieceBitboards[c][KNIGHT] | board.pieceBitboards[c][BISHOP]);
+    }
+    Bitboard minors = board.pieceBitboards[0][KNIGHT] | board.pieceBitboards[0][BISHOP] |
+        board.pieceBitboards[1][KNIGHT] | board.pieceBitboards[1][BISHOP];
+    return !others && popcount(minors) <= 1;
+}
+
+static bool startEngine(UciProcess& process, const EngineConfig& config) {
+    if (!process.start(config.command)) {
+        return false;
+    }
+    process.send("uci");
+    if (!process.waitFor("uciok", NO_CLOCK_TIMEOUT_MS)) {
+        return false;
+    }
+    for (const auto& [name, value] : config.options) {
+        process.send("setoption name " + name + " value " + value);
+    }
+    return true;
+}
+
+// a finished game: result from white's point of view (1, 0.5 or 0, -1
+// when abandoned) and why
+struct GameResult {
+    double whiteScore;
+    std::string reason;
+    // the engines are restarted before the next game
+    bool engineFailed = false;
+};
+
+// plays one game, engines[0] has white
+static GameResult playGame(UciProcess* engines[2], const std::string& opening, const MatchSettings& settings,
+                           const std::atomic<bool>& stopMatch) {
+    Board board;
+    board.loadFromFEN(opening);
+    for (int i = 0; i < 2; i++) {
+        engines[i]->send("ucinewgame");
+        engines[i]->send("isready");
+        if (!engines[i]->waitFor("readyok", NO_CLOCK_TIMEOUT_MS)) {
+            return {i == 0 ? 0.0 : 1.0, "engine did not start a new game", true};
+        }
+    }
+    std::string moves;
+    std::vector<uint64_t> history;
+    int64_t clock[2] = {settings.baseTime, settings.baseTime};
+    // the last score each side reported, from its own point of view, and
+    // how many moves in a row it met the resign or draw condition
+    int lastScore[2] = {0, 0};
+    int resignCount[2] = {0, 0};
+    int drawCount[2] = {0, 0};
+    for (int ply = 0;; ply++) {
+        char side = board.getSideToMove();
+        int us = colorIndex(side), them = us ^ 1;
+        double loss = (side == 'W') ? 0.0 : 1.0;
+        if (!hasLegalMove(board, side)) {
+            return inCheck(board, side) ? GameResult{loss, "checkmate"} : GameResult{0.5, "stalemate"};
+        }
+        if (board.getHalfmoveClock() >= 100) {
+            return {0.5, "fifty move rule"};
+        }
+        if (insufficientMaterial(board)) {
+            return {0.5, "insufficient material"};
+        }
+        uint64_t key = polyglotKey(board, side);
+        if (board.getHalfmoveClock() == 0) {
+            history.clear();
+        }
+        history.push_back(key);
+        if (std::count(history.begin(), history.end(), key) >= 3) {
+            return {0.5, "threefold repetition"};
+        }
+        if (ply >= settings.maxPlies) {
+            return {0.5, "move limit"};
+        }
+        if (stopMatch) {
+            return {-1, "match stopped"};
+        }
+
+        UciProcess& engine = *engines[us];
+        engine.send("position fen " + opening + (moves.empty() ? "" : " moves" + moves));
+        std::string go = "go";
+        int64_t timeout = NO_CLOCK_TIMEOUT_MS;
+        if (settings.nodes) {
+            go += " nodes " + std::to_string(settings.nodes);
+        } else if (settings.moveTime) {
+            go += " movetime " + std::to_string(settings.moveTime);
+            timeout = settings.moveTime + TIME_MARGIN_MS;
+        } else if (settings.baseTime) {
+            go += " wtime " + std::to_string(clock[0]) + " btime " + std::to_string(clock[1]) +
+                " winc " + std::to_string(settings.increment) + " binc " + std::to_string(settings.increment);
+            timeout = clock[us] + TIME_MARGIN_MS;
+        }
+        auto start = std::chrono::steady_clock::now();
+        engine.send(go);
+        std::string line, bestMove;
+        while (engine.readLine(line, timeout)) {
+            std::istringstream in(line);
+            std::string token;
+            in >> token;
+            if (token == "bestmove") {
+                in >> bestMove;
+                break;
+            }
+            while (token == "info" && in >> token) {
+                if (token == "score") {
+                    std::string kind;
+                    int value;
+                    if (in >> kind >> value) {
+                        lastScore[us] = (kind == "mate") ? (value > 0 ? MATE_CP : -MATE_CP) : value;
+                    }
+                }
+            }
+        }
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (bestMove.empty()) {
+            return {loss, "engine crashed or stopped responding", true};
+        }
+        if (settings.baseTime) {
+            clock[us] -= elapsed;
+            if (clock[us] < 0) {
+                return {loss, "time forfeit"};
+            }
+            clock[us] += settings.increment;
+        }
+        SanMove move;
+        if (!parseCoordinateMove(bestMove, move) ||
+            !board.movePiece(move.fromX, move.fromY, move.toX, move.toY, side, move.promotion)) {
+            return {loss, "illegal move " + bestMove};
+        }
+        moves += " " + bestMove;
+
+        // adjudication on the scores both engines report
+        resignCount[us] = (lastScore[us] <= -settings.resignScore) ? resignCount[us] + 1 : 0;
+        if (resignCount[us] >= settings.resignMoves && lastScore[them] >= settings.resignScore) {
+            return {loss, "adjudicated, resigned"};
+        }
+        drawCount[us] = (ply >= settings.drawPly && std::abs(lastScore[us]) <= settings.drawScore) ? drawCount[us] + 1 : 0;
+        if (drawCount[0] >= settings.drawMoves && drawCount[1] >= settings.drawMoves) {
+            return {0.5, "adjudicated, drawn"};
+        }
+    }
+}
+
+static bool readOpenings(const std::string& path, std::vector<std::string>& openings) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    Board board;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string fields[6];
+        int count = 0;
+        while (count < 6 && in >> fields[count]) {
+            count++;
+        }
+        if (count < 4 || fields[0][0] == '#') {
+            continue;
+        }
+        std::string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+        if (count == 6 && std::isdigit((unsigned char)fields[4][0]) && std::isdigit((unsigned char)fields[5][0])) {
+            fen += " " + fields[4] + " " + fields[5];
+        }
+        if (board.loadFromFEN(fen)) {
+            openings.push_back(board.toFEN());
+        } else {
+            std::cerr << "Skipping invalid opening " << line << std::endl;
+        }
+    }
+    return true;
+}
+
+// everything after -engine up to the next flag
+static bool parseEngine(int argc, char** argv, int& i, EngineConfig& config) {
+    while (i + 1 < argc && argv[i + 1][0] != '-') {
+        std::string arg = argv[++i];
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string key = arg.substr(0, equals), value = arg.substr(equals + 1);
+        if (key == "cmd") {
+            config.command = value;
+        } else if (key == "name") {
+            config.name = value;
+        } else if (key.compare(0, 7, "option.") == 0) {
+            config.options.push_back({key.substr(7), value});
+        } else {
+            return false;
+        }
+    }
+    if (config.name.empty()) {
+        config.name = config.command;
+    }
+    return !config.command.empty();
+}
+
+static void usage() {
+    std::cerr << "usage: match -engine cmd=PATH [name=NAME] [option.NAME=VALUE]...\n"
+                 "             -engine cmd=PATH [name=NAME] [option.NAME=VALUE]...\n"
+                 "             [-nodes N | -movetime MS | -tc SECONDS[+INCREMENT]]\n"
+                 "             [-openings FILE] [-games N] [-concurrency N]\n"
+                 "             [-sprt elo0=0 elo1=5 alpha=0.05 beta=0.05]\n"
+                 "             [-resign SCORE MOVES] [-draw PLY SCORE MOVES] [-max-plies N]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    MatchSettings settings;
+    int engineCount = 0;
+    std::string openingFile;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-engine" && engineCount < 2) {
+            if (!parseEngine(argc, argv, i, settings.engines[engineCount++])) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "-nodes" && i + 1 < argc) {
+            settings.nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-movetime" && i + 1 < argc) {
+            settings.moveTime = std::atoll(argv[++i]);
+        } else if (arg == "-tc" && i + 1 < argc) {
+            std::string tc = argv[++i];
+            size_t plus = tc.find('+');
+            settings.baseTime = (int64_t)(std::atof(tc.substr(0, plus).c_str()) * 1000);
+            settings.increment = (plus == std::string::npos) ? 0 : (int64_t)(std::atof(tc.c_str() + plus + 1) * 1000);
+        } else if (arg == "-openings" && i + 1 < argc) {
+            openingFile = argv[++i];
+        } else if (arg == "-games" && i + 1 < argc) {
+            settings.games = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-concurrency" && i + 1 < argc) {
+            settings.concurrency = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-sprt") {
+            settings.sprt = true;
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                std::string parameter = argv[++i];
+                size_t equals = parameter.find('=');
+                double value = (equals == std::string::npos) ? 0 : std::atof(parameter.c_str() + equals + 1);
+                std::string key = parameter.substr(0, equals);
+                if (key == "elo0") settings.elo0 = value;
+                else if (key == "elo1") settings.elo1 = value;
+                else if (key == "alpha") settings.alpha = value;
+                else if (key == "beta") settings.beta = value;
+            }
+        } else if (arg == "-resign" && i + 2 < argc) {
+            settings.resignScore = std::atoi(argv[++i]);
+            settings.resignMoves = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-draw" && i + 3 < argc) {
+            settings.drawPly = std::atoi(argv[++i]);
+            settings.drawScore = std::atoi(argv[++i]);
+            settings.drawMoves = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-max-plies" && i + 1 < argc) {
+            settings.maxPlies = std::max(std::atoi(argv[++i]), 1);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (engineCount != 2 || (!settings.nodes && !settings.moveTime && !settings.baseTime)) {
+        usage();
+        return 1;
+    }
+    if (!openingFile.empty() && !readOpenings(openingFile, settings.openings)) {
+        std::cerr << "Could not open " << openingFile << std::endl;
+        return 1;
+    }
+    if (settings.openings.empty()) {
+        settings.openings.push_back(START_FEN);
+    }
+    if (!settings.games) {
+        // every opening with both colours, or until the SPRT decides
+        settings.games = settings.sprt ? 1000000 : 2 * (int)settings.openings.size();
+    }
+    // an engine that exits must not take the match down with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const double lowerBound = std::log(settings.beta / (1 - settings.alpha));
+    const double upperBound = std::log((1 - settings.beta) / settings.alpha);
+    std::mutex statsMutex;
+    MatchStats stats;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stopMatch{false};
+    std::atomic<bool> startFailed{false};
+    const std::string& name0 = settings.engines[0].name;
+    const std::string& name1 = settings.engines[1].name;
+
+    auto report = [&]() {
+        double score = stats.score();
+        double margin = 1.96 * std::sqrt(stats.variance() / std::max(stats.games(), 1));
+        // no "-0.0" for an even score
+        double elo = (score == 0.5) ? 0 : eloFromScore(score);
+        double errorBar = (eloFromScore(score + margin) - eloFromScore(score - margin)) / 2;
+        std::printf("Score of %s vs %s: %d - %d - %d [%.3f] %d, Elo %.1f +/- %.1f",
+                    name0.c_str(), name1.c_str(), stats.wins, stats.losses, stats.draws, score,
+                    stats.games(), elo, errorBar);
+        if (settings.sprt) {
+            std::printf(", LLR %.2f (%.2f, %.2f)", logLikelihoodRatio(stats, settings.elo0, settings.elo1),
+                        lowerBound, upperBound);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < settings.concurrency; t++) {
+        workers.emplace_back([&]() {
+            std::unique_ptr<UciProcess> processes[2];
+            auto startEngines = [&]() {
+                for (int i = 0; i < 2; i++) {
+                    processes[i] = std::make_unique<UciProcess>();
+                    if (!startEngine(*processes[i], settings.engines[i])) {
+                        std::lock_guard<std::mutex> lock(statsMutex);
+                        std::cerr << "Could not start " << settings.engines[i].command << std::endl;
+                        stopMatch = true;
+                        startFailed = true;
+                        return false;
+                    }
+                }
+                return true;
+            };
+            if (!startEngines()) {
+                return;
+            }
+            while (!stopMatch) {
+                int game = nextGame++;
+                if (game >= settings.games) {
+                    return;
+                }
+                // consecutive games share an opening with colours swapped
+                const std::string& opening = settings.openings[(game / 2) % settings.openings.size()];
+                bool firstIsWhite = game % 2 == 0;
+                UciProcess* engines[2] = {processes[firstIsWhite ? 0 : 1].get(), processes[firstIsWhite ? 1 : 0].get()};
+                GameResult result = playGame(engines, opening, settings, stopMatch);
+                if (result.whiteScore < 0) {
+                    return;
+                }
+                if (result.engineFailed && !startEngines()) {
+                    return;
+                }
+                double firstScore = firstIsWhite ? result.whiteScore : 1 - result.whiteScore;
+
+                std::lock_guard<std::mutex> lock(statsMutex);
+                if (stopMatch) {
+                    return;
+                }
+                if (firstScore == 1) stats.wins++;
+                else if (firstScore == 0) stats.losses++;
+                else stats.draws++;
+                std::printf("Game %d (%s vs %s): %s {%s}\n", game + 1,
+                            (firstIsWhite ? name0 : name1).c_str(), (firstIsWhite ? name1 : name0).c_str(),
+                            result.whiteScore == 1 ? "1-0" : result.whiteScore == 0 ? "0-1" : "1/2-1/2",
+                            result.reason.c_str());
+                report();
+                if (settings.sprt) {
+                    double llr = logLikelihoodRatio(stats, settings.elo0, settings.elo1);
+                    if (llr >= upperBound || llr <= lowerBound) {
+                        std::printf("SPRT: %s accepted\n", llr >= upperBound ? "H1" : "H0");
+                        stopMatch = true;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return startFailed ? 1 : 0;
+}
+#endif
@@ -0,0 +1,224 @@
+// Microbenchmarks of the engine's primitives, each timed on its own on an
+// opening, a middlegame (Kiwipete) and an endgame position. Every primitive
+// is warmed up, then timed in samples of many operations; the median and
+// 99th percentile time per operation are reported over the samples, with
+// the time stamp counter's cycles per operation where there is one.
+// usage: microbench [-samples N] [filter]
+#include "Engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAS_CYCLE_COUNTER 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER 1
+#else
+#define HAS_CYCLE_COUNTER 0
+#endif
+
+#define DEFAULT_SAMPLES 200
+// a sample runs at least this long, so clock resolution does not matter
+#define SAMPLE_NANOSECONDS 200000
+#define WARMUP_NANOSECONDS 20000000
+// time allowed per benchmark, slow ones such as perft take fewer samples
+#define BUDGET_NANOSECONDS 1000000000
+#define MIN_SAMPLES 10
+#define PERFT_DEPTH 3
+
+struct NamedPosition {
+    const char* name;
+    const char* fen;
+};
+
+static const NamedPosition positions[] = {
+    {"opening", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+};
+
+static const char* typeNames[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+
+typedef std::pair<std::pair<int, int>, std::pair<int, int>> Move;
+
+// results are summed here so the compiler cannot drop the work
+static volatile uint64_t sink;
+
+static inline uint64_t cycleCount() {
+#if HAS_CYCLE_COUNTER
+    // reference cycles at the nominal frequency, not core cycles
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int64_t nanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// op runs one operation and returns something derived from its result
+static void measure(const std::string& name, int maxSamples, const std::function<uint64_t()>& op) {
+    uint64_t total = 0;
+    // warm up caches and branch predictors, and find how many operations fill a sample
+    uint64_t batch = 1;
+    int64_t start = nanoseconds(), elapsed = 0;
+    uint64_t warmupOps = 0;
+    while ((elapsed = nanoseconds() - start) < WARMUP_NANOSECONDS) {
+        total += op();
+        warmupOps++;
+    }
+    batch = std::max<uint64_t>(1, warmupOps * SAMPLE_NANOSECONDS / std::max<int64_t>(elapsed, 1));
+    int64_t sampleEstimate = std::max<int64_t>(1, elapsed / (int64_t)warmupOps * (int64_t)batch);
+    int sampleCount = (int)std::clamp<int64_t>(BUDGET_NANOSECONDS / sampleEstimate, MIN_SAMPLES, maxSamples);
+
+    std::vector<double> perOp;
+    uint64_t cycles = 0, ops = 0;
+    for (int sample = 0; sample < sampleCount; sample++) {
+        uint64_t cycleStart = cycleCount();
+        int64_t sampleStart = nanoseconds();
+        for (uint64_t i = 0; i < batch; i++) {
+            total += op();
+        }
+        int64_t sampleTime = nanoseconds() - sampleStart;
+        cycles += cycleCount() - cycleStart;
+        ops += batch;
+        perOp.push_back((double)sampleTime / batch);
+    }
+    sink = sink + total;
+    std::sort(perOp.begin(), perOp.end());
+    double median = perOp[perOp.size() / 2];
+    double p99 = perOp[std::min(perOp.size() - 1, perOp.size() * 99 / 100)];
+    std::printf("%-34s %12.1f %12.1f", name.c_str(), median, p99);
+    if (HAS_CYCLE_COUNTER) {
+        std::printf(" %12.1f", (double)cycles / ops);
+    } else {
+        std::printf(" %12s", "-");
+    }
+    std::printf(" %10llu\n", (unsigned long long)ops);
+    std::fflush(stdout);
+}
+
+static std::vector<Move> legalMoves(Board& board, char side) {
+    std::vector<Move> moves;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board.board[row][col];
+            if (piece && piece->getColor() == side) {
+                for (auto target : board.getLegalMoves(row, col, side)) {
+                    moves.push_back({{row, col}, target});
+                }
+            }
+        }
+    }
+    return moves;
+}
+
+int main(int argc, char** argv) {
+    int maxSamples = DEFAULT_SAMPLES;
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-samples" && i + 1 < argc) {
+            maxSamples = std::max(std::atoi(argv[++i]), MIN_SAMPLES);
+        } else if (arg[0] != '-' && filter.empty()) {
+            filter = arg;
+        } else {
+            std::fprintf(stderr, "usage: microbench [-samples N] [filter]\n");
+            return 1;
+        }
+    }
+    auto run = [&](const std::string& name, const std::function<uint64_t()>& op) {
+        if (name.find(filter) != std::string::npos) {
+            measure(name, maxSamples, op);
+        }
+    };
+
+    std::printf("%-34s %12s %12s %12s %10s\n", "benchmark", "median ns", "p99 ns",
+                HAS_CYCLE_COUNTER ? "cycles/op" : "", "ops");
+    for (const NamedPosition& position : positions) {
+        std::string prefix = std::string(position.name) + " ";
+        Board board;
+        board.loadFromFEN(position.fen);
+        char side = board.getSideToMove();
+        std::vector<Move> moves = legalMoves(board, side);
+
+        run(prefix + "loadFromFEN", [&]() {
+            return (uint64_t)board.loadFromFEN(position.fen);
+        });
+        run(prefix + "Board copy", [&]() {
+            Board copy(board);
+            return copy.hashKey;
+        });
+
+        for (int type = PAWN; type <= KING; type++) {
+            std::vector<std::pair<int, int>> squares;
+            Bitboard pieces = board.pieceBitboards[colorIndex(side)][type];
+            while (pieces) {
+                int square = popLsb(pieces);
+                squares.push_back({square / 8, square % 8});
+            }
+            if (squares.empty()) {
+                continue;
+            }
+            size_t next = 0;
+            run(prefix + "getLegalMoves " + typeNames[type], [&]() {
+                auto [row, col] = squares[next];
+                next = (next + 1) % squares.size();
+                return (uint64_t)board.getLegalMoves(row, col, side).size();
+            });
+        }
+
+        if (moves.empty()) {
+            continue;
+        }
+        size_t next = 0;
+        run(prefix + "isLegalMove", [&]() {
+            auto [from, to] = moves[next];
+            next = (next + 1) % moves.size();
+            return (uint64_t)board.isLegalMove(from.first, from.second, to.first, to.second);
+        });
+
+        // a leaf: make the move, evaluate with the cache warm, unmake
+        Engine engine(board, side);
+        next = 0;
+        run(prefix + "moveAndUnmove", [&]() {
+            auto [from, to] = moves[next];
+            next = (next + 1) % moves.size();
+            int eval = 0;
+            engine.moveAndUnmove(from.first, from.second, to.first, to.second, eval, 1, side, board);
+            return (uint64_t)eval;
+        });
+
+        // the positions after each move, evaluated in turn with a one-entry
+        // cache, so every call computes the full evaluation
+        std::vector<Board> children;
+        for (const Move& move : moves) {
+            children.push_back(board);
+            children.back().movePiece(move.first.first, move.first.second, move.second.first, move.second.second, side);
+        }
+        Engine uncached(board, side);
+        uncached.setHashSize(0);
+        next = 0;
+        run(prefix + "Engine::evaluate", [&]() {
+            Board& child = children[next];
+            next = (next + 1) % children.size();
+            return (uint64_t)uncached.evaluate(child);
+        });
+
+        for (int depth = 1; depth <= PERFT_DEPTH; depth++) {
+            run(prefix + "perft " + std::to_string(depth), [&]() {
+                long long captures = 0;
+                return (uint64_t)board.perft(depth, side, captures);
+            });
+        }
+    }
+    return 0;
+}
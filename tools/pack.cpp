@@ -0,0 +1,214 @@
+// Converts FEN/EPD datasets to 32-byte PackedPosition records and back.
+// A line may carry a game result ("1-0", "0-1", "1/2-1/2" or "[1.0]",
+// "[0.5]", "[0.0]") and EPD operations "ce" (centipawns for the side to
+// move) and "c9" (the result in quotes). -unpack prints the records of a
+// dataset as EPD; -scan streams a dataset through the batch evaluator.
+// usage: pack_positions [-o out.bin] [positions.epd...]
+//        pack_positions -unpack data.bin
+//        pack_positions -scan data.bin
+#include "BatchEval.h"
+#include "PackedPosition.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// records collected before a write
+#define WRITE_BATCH 4096
+
+static bool readResult(const std::string& token, uint8_t& result) {
+    if (token == "1-0" || token == "[1.0]" || token == "[1]") {
+        result = WHITE_WINS;
+    } else if (token == "0-1" || token == "[0.0]" || token == "[0]") {
+        result = BLACK_WINS;
+    } else if (token == "1/2-1/2" || token == "[0.5]") {
+        result = DRAW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isNumber(const std::string& token) {
+    return !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+}
+
+// the position fields and optional counters go to the board, what follows
+// is searched for a result and EPD operations
+static bool packLine(const std::string& line, Board& board, PackedPosition& packed) {
+    std::istringstream in(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (in >> token) {
+        tokens.push_back(token);
+    }
+    if (tokens.size() < 4) {
+        return false;
+    }
+    std::string fen = tokens[0] + " " + tokens[1] + " " + tokens[2] + " " + tokens[3];
+    size_t next = 4;
+    if (tokens.size() >= 6 && isNumber(tokens[4]) && isNumber(tokens[5])) {
+        fen += " " + tokens[4] + " " + tokens[5];
+        next = 6;
+    }
+    if (!board.loadFromFEN(fen)) {
+        return false;
+    }
+    int score = PACKED_NO_SCORE;
+    uint8_t result = NO_RESULT;
+    for (size_t i = next; i < tokens.size(); i++) {
+        std::string word = tokens[i];
+        if (!word.empty() && word.back() == ';') {
+            word.pop_back();
+        }
+        if (readResult(word, result)) {
+            continue;
+        }
+        if (word == "ce" && i + 1 < tokens.size()) {
+            score = std::atoi(tokens[++i].c_str());
+            if (board.getSideToMove() == 'B') {
+                score = -score;
+            }
+        } else if (word == "c9" && i + 1 < tokens.size()) {
+            std::string operand = tokens[++i];
+            operand.erase(std::remove(operand.begin(), operand.end(), '"'), operand.end());
+            operand.erase(std::remove(operand.begin(), operand.end(), ';'), operand.end());
+            readResult(operand, result);
+        }
+    }
+    packed = packPosition(board, score, result);
+    return true;
+}
+
+static int pack(const std::vector<std::string>& inputs, const std::string& output) {
+    FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    Board board;
+    std::vector<PackedPosition> records;
+    records.reserve(WRITE_BATCH);
+    uint64_t packedCount = 0, skipped = 0;
+    for (const std::string& input : inputs) {
+        std::ifstream file;
+        if (input != "-") {
+            file.open(input);
+            if (!file) {
+                std::cerr << "Could not open " << input << std::endl;
+                continue;
+            }
+        }
+        std::istream& in = (input == "-") ? std::cin : file;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos || line[0] == '#') {
+                continue;
+            }
+            PackedPosition packed;
+            if (!packLine(line, board, packed)) {
+                skipped++;
+                continue;
+            }
+            records.push_back(packed);
+            if (records.size() == WRITE_BATCH) {
+                std::fwrite(records.data(), sizeof(PackedPosition), records.size(), out);
+                records.clear();
+            }
+            packedCount++;
+        }
+    }
+    std::fwrite(records.data(), sizeof(PackedPosition), records.size(), out);
+    bool failed = std::ferror(out);
+    if (out != stdout) {
+        failed |= std::fclose(out) != 0;
+    }
+    std::cerr << "Packed " << packedCount << " positions, skipped " << skipped << " lines" << std::endl;
+    return failed ? 1 : 0;
+}
+
+static int unpack(const std::string& path) {
+    PackedDataset dataset;
+    if (!dataset.open(path)) {
+        std::cerr << "Could not open " << path << " as a packed dataset" << std::endl;
+        return 1;
+    }
+    static const char* resultNames[] = {"0-1", "1/2-1/2", "1-0"};
+    Board board;
+    for (const PackedPosition& packed : dataset) {
+        if (!board.loadPacked(packed)) {
+            std::cout << "# invalid record" << std::endl;
+            continue;
+        }
+        std::cout << board.toFEN();
+        if (packed.score != PACKED_NO_SCORE) {
+            std::cout << " ce " << (packed.sideToMove() == 'W' ? packed.score : -packed.score) << ";";
+        }
+        if (packed.result < NO_RESULT) {
+            std::cout << " c9 \"" << resultNames[packed.result] << "\";";
+        }
+        std::cout << '\n';
+    }
+    return 0;
+}
+
+// sums static scores over the whole dataset a batch at a time
+static int scan(const std::string& path) {
+    PackedDataset dataset;
+    if (!dataset.open(path)) {
+        std::cerr << "Could not open " << path << " as a packed dataset" << std::endl;
+        return 1;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    PositionBatch batch;
+    std::vector<int> scores;
+    long long total = 0;
+    for (size_t i = 0; i < dataset.size(); i++) {
+        batch.add(dataset[i]);
+        if (batch.size() == WRITE_BATCH || i + 1 == dataset.size()) {
+            batch.evaluate(scores);
+            for (int score : scores) {
+                total += score;
+            }
+            batch.clear();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << dataset.size() << " positions in " << seconds << " s, "
+              << dataset.size() / std::max(seconds, 1e-9) / 1e6 << " M positions/s, "
+              << dataset.size() * sizeof(PackedPosition) / std::max(seconds, 1e-9) / 1e6 << " MB/s, mean score "
+              << (dataset.size() ? total / (long long)dataset.size() : 0) << " (" << PositionBatch::simdName() << ")"
+              << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-unpack" && i + 1 < argc) {
+            return unpack(argv[i + 1]);
+        } else if (arg == "-scan" && i + 1 < argc) {
+            return scan(argv[i + 1]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg[0] == '-' && arg != "-") {
+            std::cerr << "usage: pack_positions [-o out.bin] [positions.epd...]\n"
+                         "       pack_positions -unpack data.bin\n"
+                         "       pack_positions -scan data.bin" << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        inputs.push_back("-");
+    }
+    return pack(inputs, output);
+}
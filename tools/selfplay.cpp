@@ -0,0 +1,312 @@
+// Self-play data generator: every worker plays its own games, opening with
+// random moves and then searching a fixed number of nodes per move, and
+// records each searched position with its score and the game's result as
+// PackedPosition records. Positions already written are skipped.
+// usage: selfplay [-positions N] [-nodes N] [-threads N] [-random-plies N]
+//                 [-max-plies N] [-seed N] -o data.bin
+#include "Engine.h"
+#include "PackedPosition.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define DEFAULT_POSITIONS 1000000
+#define DEFAULT_NODES 5000
+#define DEFAULT_RANDOM_PLIES 8
+#define DEFAULT_MAX_PLIES 400
+// each worker's eval cache
+#define WORKER_HASH_MB 8
+// records a worker collects before taking the file lock
+#define WRITER_BUFFER 4096
+// 2^DEDUP_BITS keys, 8 bytes each
+#define DEDUP_BITS 24
+#define DEDUP_PROBES 4
+// a side this far ahead for RESIGN_PLIES plies in a row wins; mates found
+// by the search are left to the board
+#define RESIGN_SCORE 1500
+#define RESIGN_PLIES 8
+
+// lock-free set of position keys. When every probed slot is taken the key
+// is forgotten, so memory stays fixed and a rare duplicate gets through.
+class DedupTable {
+private:
+    std::vector<std::atomic<uint64_t>> slots;
+public:
+    DedupTable() : slots(size_t(1) << DEDUP_BITS) {}
+
+    // true the first time a key is seen
+    bool insert(uint64_t key) {
+        key |= 1;  // 0 marks an empty slot
+        size_t mask = slots.size() - 1;
+        for (int probe = 0; probe < DEDUP_PROBES; probe++) {
+            std::atomic<uint64_t>& slot = slots[(key + probe) & mask];
+            uint64_t current = slot.load(std::memory_order_relaxed);
+            if (current == key) {
+                return false;
+            }
+            if (current == 0) {
+                if (slot.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+                    return true;
+                }
+                if (current == key) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// shared output file, every worker writes whole buffers under the lock
+class DatasetWriter {
+private:
+    FILE* file;
+    std::mutex mutex;
+    bool failed = false;
+public:
+    explicit DatasetWriter(FILE* file) : file(file) {}
+
+    void write(const std::vector<PackedPosition>& records) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (std::fwrite(records.data(), sizeof(PackedPosition), records.size(), file) != records.size()) {
+            failed = true;
+        }
+    }
+
+    bool hasFailed() const {
+        return failed;
+    }
+};
+
+struct Settings {
+    uint64_t positions = DEFAULT_POSITIONS;
+    uint64_t nodes = DEFAULT_NODES;
+    int randomPlies = DEFAULT_RANDOM_PLIES;
+    int maxPlies = DEFAULT_MAX_PLIES;
+};
+
+struct Counters {
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> games{0};
+    // white wins, draws, black wins
+    std::atomic<uint64_t> results[3] = {};
+};
+
+static bool inCheck(const Board& board, char side) {
+    int us = colorIndex(side), them = us ^ 1;
+    Bitboard occupied = board.colorBitboards[0] | board.colorBitboards[1];
+    int kingSquare = lsb(board.pieceBitboards[us][KING]);
+    const Bitboard (&attackers)[6] = board.pieceBitboards[them];
+    return (attackTables.pawn[us][kingSquare] & attackers[PAWN]) ||
+        (attackTables.knight[kingSquare] & attackers[KNIGHT]) ||
+        (attackTables.king[kingSquare] & attackers[KING]) ||
+        (bishopAttacks(kingSquare, occupied) & (attackers[BISHOP] | attackers[QUEEN])) ||
+        (rookAttacks(kingSquare, occupied) & (attackers[ROOK] | attackers[QUEEN]));
+}
+
+// bare kings, or a single minor piece against a bare king
+static bool insufficientMaterial(const Board& board) {
+    Bitboard others = board.colorBitboards[0] | board.colorBitboards[1];
+    for (int c = 0; c < 2; c++) {
+        others &= ~(board.pieceBitboards[c][KING] | board.pieceBitboards[c][KNIGHT] | board.pieceBitboards[c][BISHOP]);
+    }
+    Bitboard minors = board.pieceBitboards[0][KNIGHT] | board.pieceBitboards[0][BISHOP] |
+        board.pieceBitboards[1][KNIGHT] | board.pieceBitboards[1][BISHOP];
+    return !others && popcount(minors) <= 1;
+}
+
+static void legalMoves(Board& board, char side, std::vector<std::pair<int, int>>& from, std::vector<std::pair<int, int>>& to) {
+    from.clear();
+    to.clear();
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board.board[row][col];
+            if (piece && piece->getColor() == side) {
+                for (auto target : board.getLegalMoves(row, col, side)) {
+                    from.push_back({row, col});
+                    to.push_back(target);
+                }
+            }
+        }
+    }
+}
+
+// plays random moves from the start position; false if the game ended on the way
+static bool randomOpening(Board& board, int plies, std::mt19937_64& rng) {
+    board.loadFromFEN(START_FEN);
+    std::vector<std::pair<int, int>> from, to;
+    for (int ply = 0; ply < plies; ply++) {
+        char side = board.getSideToMove();
+        legalMoves(board, side, from, to);
+        if (from.empty()) {
+            return false;
+        }
+        size_t pick = rng() % from.size();
+        board.movePiece(from[pick].first, from[pick].second, to[pick].first, to[pick].second, side);
+    }
+    return true;
+}
+
+// one game; its positions are added to buffer with the result once it is known
+static void playGame(Board& board, Engine& engine, const Settings& settings, std::mt19937_64& rng,
+                     DedupTable& dedup, Counters& counters, std::vector<PackedPosition>& buffer) {
+    int randomPlies = settings.randomPlies + (int)(rng() % 2);
+    while (!randomOpening(board, randomPlies, rng)) {
+    }
+    SearchLimits limits;
+    limits.nodes = settings.nodes;
+    std::vector<PackedPosition> game;
+    // keys since the last capture or pawn move, for repetitions
+    std::vector<uint64_t> history;
+    int resignCount[2] = {0, 0};
+    uint8_t result = DRAW;
+    for (int ply = 0; ply < settings.maxPlies; ply++) {
+        if (counters.written >= settings.positions) {
+            return;
+        }
+        char side = board.getSideToMove();
+        if (board.getHalfmoveClock() >= 100 || insufficientMaterial(board)) {
+            break;
+        }
+        uint64_t key = polyglotKey(board, side);
+        if (board.getHalfmoveClock() == 0) {
+            history.clear();
+        }
+        history.push_back(key);
+        if (std::count(history.begin(), history.end(), key) >= 3) {
+            break;
+        }
+
+        SearchInfo info = engine.search(side, limits);
+        auto [from, to] = info.bestMove;
+        if (from.first < 0) {
+            if (inCheck(board, side)) {
+                result = (side == 'W') ? BLACK_WINS : WHITE_WINS;
+            }
+            break;
+        }
+        // checks and mate scores make poor training targets
+        if (std::abs(info.score) < MATE_BOUND && !inCheck(board, side)) {
+            if (dedup.insert(key)) {
+                game.push_back(packPosition(board, info.score));
+            } else {
+                counters.duplicates++;
+            }
+        }
+        // both sides agree one of them is winning
+        for (int c = 0; c < 2; c++) {
+            int score = (c == 0) ? info.score : -info.score;
+            resignCount[c] = (score >= RESIGN_SCORE && score < MATE_BOUND) ? resignCount[c] + 1 : 0;
+        }
+        if (resignCount[0] >= RESIGN_PLIES || resignCount[1] >= RESIGN_PLIES) {
+            result = (resignCount[0] >= RESIGN_PLIES) ? WHITE_WINS : BLACK_WINS;
+            break;
+        }
+        if (!board.movePiece(from.first, from.second, to.first, to.second, side)) {
+            break;
+        }
+    }
+    for (PackedPosition& packed : game) {
+        packed.result = result;
+    }
+    buffer.insert(buffer.end(), game.begin(), game.end());
+    counters.written += game.size();
+    counters.games++;
+    counters.results[result == WHITE_WINS ? 0 : result == DRAW ? 1 : 2]++;
+}
+
+int main(int argc, char** argv) {
+    Settings settings;
+    int threadCount = std::max((int)std::thread::hardware_concurrency(), 1);
+    uint64_t seed = std::random_device{}();
+    std::string output;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-positions" && i + 1 < argc) {
+            settings.positions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-nodes" && i + 1 < argc) {
+            settings.nodes = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "-threads" && i + 1 < argc) {
+            threadCount = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-random-plies" && i + 1 < argc) {
+            settings.randomPlies = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "-max-plies" && i + 1 < argc) {
+            settings.maxPlies = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            output.clear();
+            break;
+        }
+    }
+    if (output.empty()) {
+        std::cerr << "usage: selfplay [-positions N] [-nodes N] [-threads N] [-random-plies N]\n"
+                     "                [-max-plies N] [-seed N] -o data.bin" << std::endl;
+        return 1;
+    }
+    FILE* file = std::fopen(output.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    DatasetWriter writer(file);
+    DedupTable dedup;
+    Counters counters;
+    std::atomic<int> running{threadCount};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&, t]() {
+            std::mt19937_64 rng(seed + t);
+            Board board;
+            Engine engine(board, 'W');
+            engine.setThreads(1);
+            engine.setHashSize(WORKER_HASH_MB);
+            std::vector<PackedPosition> buffer;
+            buffer.reserve(WRITER_BUFFER + DEFAULT_MAX_PLIES);
+            while (counters.written < settings.positions) {
+                playGame(board, engine, settings, rng, dedup, counters, buffer);
+                if (buffer.size() >= WRITER_BUFFER) {
+                    writer.write(buffer);
+                    buffer.clear();
+                }
+            }
+            writer.write(buffer);
+            running--;
+        });
+    }
+
+    auto report = [&]() {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << counters.written << " positions, " << counters.games << " games (+" << counters.results[0]
+                  << " =" << counters.results[1] << " -" << counters.results[2] << "), "
+                  << counters.duplicates << " duplicates, "
+                  << (uint64_t)(counters.written / std::max(seconds, 1e-9)) << " positions/s" << std::endl;
+    };
+    while (running > 0) {
+        for (int tick = 0; tick < 20 && running > 0; tick++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        report();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    bool failed = writer.hasFailed() || std::fclose(file) != 0;
+    if (failed) {
+        std::cerr << "Could not write " << output << std::endl;
+    }
+    return failed ? 1 : 0;
+}
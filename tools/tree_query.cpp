@@ -0,0 +1,160 @@
+// Queries search trees written by badfish -tree (see SearchTree.h).
+// summary: nodes by how they ended, effective branching factor per
+//          iteration and moves searched per remaining depth, and a
+//          histogram of the position of the move that cut off
+// children N: node N and the nodes below it
+// path N: the moves from the root down to node N
+// key HEX: every node of a position
+// usage: tree_query tree.bin [summary | children N | path N | key HEX]
+#include "SearchTree.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// cutoff positions counted separately, later ones share the last bar
+#define HISTOGRAM_BUCKETS 12
+#define HISTOGRAM_WIDTH 50
+
+static const char* reasonNames[] = {"searched", "beta cutoff", "leaf", "stopped", "draw", "bitbase win"};
+
+static std::string moveText(const SearchTreeNode& node) {
+    if (node.from == SEARCH_TREE_NO_SQUARE) {
+        return "-";
+    }
+    std::string text;
+    for (int square : {node.from, node.to}) {
+        text += (char)('a' + square % 8);
+        text += (char)('8' - square / 8);
+    }
+    return text;
+}
+
+static void printNode(const std::vector<SearchTreeNode>& nodes, size_t index, const char* indent) {
+    const SearchTreeNode& node = nodes[index];
+    std::printf("%s#%zu %s depth %d iteration %d %s to move, window [%d, %d], score %d, %s after %d moves, key %016" PRIx64 "\n",
+                indent, index, moveText(node).c_str(), node.depth, node.iteration, node.side ? "black" : "white",
+                node.alpha, node.beta, node.score,
+                node.reason < sizeof(reasonNames) / sizeof(reasonNames[0]) ? reasonNames[node.reason] : "?",
+                node.movesSearched, node.key);
+}
+
+static void summary(const std::vector<SearchTreeNode>& nodes) {
+    uint64_t reasons[6] = {};
+    uint64_t byIteration[256] = {};
+    // expanded nodes and the moves they searched, by remaining depth
+    uint64_t expanded[256] = {}, moves[256] = {};
+    uint64_t histogram[HISTOGRAM_BUCKETS] = {};
+    uint64_t cutoffs = 0;
+    for (const SearchTreeNode& node : nodes) {
+        if (node.reason < 6) {
+            reasons[node.reason]++;
+        }
+        byIteration[node.iteration]++;
+        if (node.reason == TREE_SEARCHED || node.reason == TREE_BETA_CUTOFF) {
+            expanded[node.depth]++;
+            moves[node.depth] += node.movesSearched;
+        }
+        if (node.reason == TREE_BETA_CUTOFF) {
+            cutoffs++;
+            histogram[std::clamp<int>(node.movesSearched, 1, HISTOGRAM_BUCKETS) - 1]++;
+        }
+    }
+    std::printf("%zu nodes\n", nodes.size());
+    for (int reason = 0; reason < 6; reason++) {
+        if (reasons[reason]) {
+            std::printf("  %-12s %10" PRIu64 " (%.1f%%)\n", reasonNames[reason], reasons[reason],
+                        100.0 * reasons[reason] / nodes.size());
+        }
+    }
+
+    std::printf("\nnodes by iteration, effective branching factor\n");
+    uint64_t previous = 0;
+    for (int iteration = 0; iteration < 256; iteration++) {
+        if (!byIteration[iteration]) {
+            continue;
+        }
+        std::printf("  %3d %10" PRIu64, iteration, byIteration[iteration]);
+        if (previous) {
+            std::printf("  %.2f", (double)byIteration[iteration] / previous);
+        }
+        std::printf("\n");
+        previous = byIteration[iteration];
+    }
+
+    std::printf("\nmoves searched per expanded node by remaining depth\n");
+    for (int depth = 255; depth > 0; depth--) {
+        if (expanded[depth]) {
+            std::printf("  %3d %10" PRIu64 " nodes %8.2f moves\n", depth, expanded[depth], (double)moves[depth] / expanded[depth]);
+        }
+    }
+
+    if (!cutoffs) {
+        return;
+    }
+    std::printf("\nposition of the cutoff move, %" PRIu64 " cutoffs\n", cutoffs);
+    uint64_t largest = *std::max_element(histogram, histogram + HISTOGRAM_BUCKETS);
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        int width = (int)(histogram[bucket] * HISTOGRAM_WIDTH / std::max<uint64_t>(largest, 1));
+        std::printf("  %3d%s %10" PRIu64 " %5.1f%% %s\n", bucket + 1, bucket == HISTOGRAM_BUCKETS - 1 ? "+" : " ",
+                    histogram[bucket], 100.0 * histogram[bucket] / cutoffs, std::string(width, '#').c_str());
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: tree_query tree.bin [summary | children N | path N | key HEX]\n");
+        return 1;
+    }
+    std::vector<SearchTreeNode> nodes;
+    if (!readSearchTree(argv[1], nodes)) {
+        std::fprintf(stderr, "Could not read %s as a search tree\n", argv[1]);
+        return 1;
+    }
+    std::string command = (argc > 2) ? argv[2] : "summary";
+    if (command == "summary") {
+        summary(nodes);
+        return 0;
+    }
+    if (argc < 4) {
+        std::fprintf(stderr, "%s needs an argument\n", command.c_str());
+        return 1;
+    }
+    if (command == "key") {
+        uint64_t key = std::strtoull(argv[3], nullptr, 16);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].key == key) {
+                printNode(nodes, i, "");
+            }
+        }
+        return 0;
+    }
+    size_t index = std::strtoull(argv[3], nullptr, 10);
+    if (index >= nodes.size()) {
+        std::fprintf(stderr, "There are only %zu nodes\n", nodes.size());
+        return 1;
+    }
+    if (command == "children") {
+        printNode(nodes, index, "");
+        // children come after their parent, in the order they were searched
+        for (size_t i = index + 1; i < nodes.size(); i++) {
+            if (nodes[i].parent == index) {
+                printNode(nodes, i, "  ");
+            }
+        }
+    } else if (command == "path") {
+        std::vector<size_t> path;
+        for (size_t i = index; i != SEARCH_TREE_ROOT; i = nodes[i].parent) {
+            path.push_back(i);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            printNode(nodes, *it, "");
+        }
+    } else {
+        std::fprintf(stderr, "Unknown command %s\n", command.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+// Texel tuning of the material values and piece-square tables: minimises
+// the mean squared error between the game results of a packed dataset and
+// a sigmoid of the evaluation, then writes a new PieceValue.h.
+// The evaluation is linear in these parameters, so every position is
+// scored once with Engine::evaluate and only the remainder not owed to
+// material and piece-square tables is kept; an epoch then rescores the
+// positions from their packed pieces, spread over all cores, and takes
+// one Adam step on the full gradient.
+// usage: tune [-epochs N] [-rate R] [-k K] [-threads N] [-o PieceValue.h] data.bin
+#include "Endgame.h"
+#include "Engine.h"
+#include "PackedPosition.h"
+#include "PieceValue.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_EPOCHS 200
+#define DEFAULT_RATE 1.0
+// epochs between progress reports, the header is rewritten at each
+#define REPORT_INTERVAL 10
+#define ADAM_BETA1 0.9
+#define ADAM_BETA2 0.999
+#define ADAM_EPSILON 1e-8
+
+// parameter layout: piece-square values indexed [type][table row * 8 + col]
+// as in PieceValue.h, middlegame then endgame, then the material values
+#define TABLE_PARAMS (6 * 64)
+#define MG_TABLE 0
+#define EG_TABLE TABLE_PARAMS
+#define MG_MATERIAL (2 * TABLE_PARAMS)
+#define EG_MATERIAL (2 * TABLE_PARAMS + 6)
+#define PARAM_COUNT (2 * TABLE_PARAMS + 12)
+
+// what is left of a dataset record once the tuned terms are taken out
+struct TuningEntry {
+    const PackedPosition* packed;
+    // Engine::evaluate minus the material and piece-square score
+    float remainder;
+    // white's score: 0, 0.5 or 1
+    float result;
+    uint8_t phase;
+};
+
+static void parallelFor(size_t count, int threadCount, const std::function<void(int, size_t, size_t)>& body) {
+    std::vector<std::thread> threads;
+    size_t chunk = (count + threadCount - 1) / threadCount;
+    for (int t = 0; t < threadCount; t++) {
+        size_t begin = std::min(count, t * chunk), end = std::min(count, begin + chunk);
+        threads.emplace_back(body, t, begin, end);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+static void initialParameters(std::vector<double>& params) {
+    const int (*middleGame[6])[8] = {pawnMiddleGameTable, knightMiddleGameTable, bishopMiddleGameTable,
+                                     rookMiddleGameTable, queenMiddleGameTable, kingMiddleGameTable};
+    const int (*endGame[6])[8] = {pawnEndGameTable, knightEndGameTable, bishopEndGameTable,
+                                  rookEndGameTable, queenEndGameTable, kingEndGameTable};
+    params.assign(PARAM_COUNT, 0);
+    for (int type = PAWN; type <= KING; type++) {
+        for (int i = 0; i < 64; i++) {
+            params[MG_TABLE + type * 64 + i] = middleGame[type][i / 8][i % 8];
+            params[EG_TABLE + type * 64 + i] = endGame[type][i / 8][i % 8];
+        }
+        params[MG_MATERIAL + type] = pieceMiddleGameValues[type];
+        params[EG_MATERIAL + type] = pieceEndGameValues[type];
+    }
+}
+
+// calls visit(type, table index, sign) for every piece of a record
+template <typename Visit>
+static inline void forEachPiece(const PackedPosition& packed, Visit visit) {
+    Bitboard occupied = packed.occupied;
+    for (int index = 0; occupied; index++) {
+        int square = popLsb(occupied);
+        int code = packed.pieceCode(index) - 1;
+        int color = code / 6, type = code % 6;
+        // tables are written from the owner's back rank, which is row 7 for white
+        int row = square / 8, col = square % 8;
+        int tableRow = (color == 0) ? 7 - row : row;
+        visit(type, tableRow * 8 + col, (color == 0) ? 1.0 : -1.0);
+    }
+}
+
+static inline double evaluateEntry(const TuningEntry& entry, const std::vector<double>& params) {
+    double mg = 0, eg = 0;
+    forEachPiece(*entry.packed, [&](int type, int index, double sign) {
+        mg += sign * (params[MG_TABLE + type * 64 + index] + params[MG_MATERIAL + type]);
+        eg += sign * (params[EG_TABLE + type * 64 + index] + params[EG_MATERIAL + type]);
+    });
+    return (mg * entry.phase + eg * (MAX_PHASE - entry.phase)) / MAX_PHASE + entry.remainder;
+}
+
+static inline double sigmoid(double eval, double k) {
+    return 1 / (1 + std::pow(10.0, -k * eval / 400));
+}
+
+static double meanError(const std::vector<TuningEntry>& entries, const std::vector<double>& params,
+                        double k, int threadCount) {
+    std::vector<double> sums(threadCount, 0);
+    parallelFor(entries.size(), threadCount, [&](int t, size_t begin, size_t end) {
+        double sum = 0;
+        for (size_t i = begin; i < end; i++) {
+            double error = entries[i].result - sigmoid(evaluateEntry(entries[i], params), k);
+            sum += error * error;
+        }
+        sums[t] = sum;
+    });
+    double total = 0;
+    for (double sum : sums) {
+        total += sum;
+    }
+    return total / std::max<size_t>(entries.size(), 1);
+}
+
+// gradient of the mean error, returns the error itself
+static double gradient(const std::vector<TuningEntry>& entries, const std::vector<double>& params,
+                       double k, int threadCount, std::vector<double>& grad) {
+    std::vector<std::vector<double>> partial(threadCount, std::vector<double>(PARAM_COUNT, 0));
+    std::vector<double> sums(threadCount, 0);
+    parallelFor(entries.size(), threadCount, [&](int t, size_t begin, size_t end) {
+        std::vector<double>& g = partial[t];
+        double sum = 0;
+        for (size_t i = begin; i < end; i++) {
+            const TuningEntry& entry = entries[i];
+            double s = sigmoid(evaluateEntry(entry, params), k);
+            double error = entry.result - s;
+            sum += error * error;
+            // d(error^2)/d(eval), split between the middlegame and endgame halves
+            double slope = -2 * error * s * (1 - s) * k * std::log(10.0) / 400;
+            double mgSlope = slope * entry.phase / MAX_PHASE;
+            double egSlope = slope * (MAX_PHASE - entry.phase) / MAX_PHASE;
+            forEachPiece(*entry.packed, [&](int type, int index, double sign) {
+                g[MG_TABLE + type * 64 + index] += sign * mgSlope;
+                g[EG_TABLE + type * 64 + index] += sign * egSlope;
+                g[MG_MATERIAL + type] += sign * mgSlope;
+                g[EG_MATERIAL + type] += sign * egSlope;
+            });
+        }
+        sums[t] = sum;
+    });
+    grad.assign(PARAM_COUNT, 0);
+    double total = 0;
+    for (int t = 0; t < threadCount; t++) {
+        for (int p = 0; p < PARAM_COUNT; p++) {
+            grad[p] += partial[t][p];
+        }
+        total += sums[t];
+    }
+    double n = std::max<size_t>(entries.size(), 1);
+    for (double& value : grad) {
+        value /= n;
+    }
+    return total / n;
+}
+
+// the scaling constant that fits the current evaluation best, by golden
+// section search; the error is close to unimodal in k
+static double fitScalingConstant(const std::vector<TuningEntry>& entries, const std::vector<double>& params,
+                                 int threadCount) {
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.1, high = 4.0;
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    double errorA = meanError(entries, params, a, threadCount), errorB = meanError(entries, params, b, threadCount);
+    while (high - low > 0.001) {
+        if (errorA < errorB) {
+            high = b;
+            b = a;
+            errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = meanError(entries, params, a, threadCount);
+        } else {
+            low = a;
+            a = b;
+            errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = meanError(entries, params, b, threadCount);
+        }
+    }
+    return (low + high) / 2;
+}
+
+static void writeTable(std::ostream& out, const char* name, const std::vector<double>& params, int offset) {
+    out << "const int " << name << "[8][8] = {\n";
+    for (int row = 0; row < 8; row++) {
+        out << "    {";
+        for (int col = 0; col < 8; col++) {
+            char value[16];
+            std::snprintf(value, sizeof(value), "%4d", (int)std::lround(params[offset + row * 8 + col]));
+            out << value << (col < 7 ? "," : "");
+        }
+        out << "}" << (row < 7 ? "," : "") << "\n";
+    }
+    out << "};\n\n";
+}
+
+static void writeValues(std::ostream& out, const char* name, const std::vector<double>& params, int offset) {
+    out << "const int " << name << "[6] = {";
+    for (int type = PAWN; type <= KING; type++) {
+        out << (type == KING ? 0 : std::lround(params[offset + type])) << (type < KING ? ", " : "");
+    }
+    out << "};\n";
+}
+
+static bool writeHeader(const std::string& path, const std::vector<double>& params) {
+    static const char* names[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+    std::ofstream out(path);
+    out << "#ifndef PIECEVALUE_H\n#define PIECEVALUE_H\n\n";
+    out << "// material value indexed by PieceType\n";
+    writeValues(out, "pieceMiddleGameValues", params, MG_MATERIAL);
+    writeValues(out, "pieceEndGameValues", params, EG_MATERIAL);
+    out << "\n// contribution of each piece to the game phase, 24 = all pieces on the board\n";
+    out << "const int piecePhase[6] = {";
+    for (int type = PAWN; type <= KING; type++) {
+        out << piecePhase[type] << (type < KING ? ", " : "");
+    }
+    out << "};\n\n// piece-square tables, row 0 is the owner's back rank\n\n";
+    for (int type = PAWN; type <= KING; type++) {
+        writeTable(out, (std::string(names[type]) + "MiddleGameTable").c_str(), params, MG_TABLE + type * 64);
+        writeTable(out, (std::string(names[type]) + "EndGameTable").c_str(), params, EG_TABLE + type * 64);
+    }
+    out << "#endif\n";
+    return (bool)out;
+}
+
+int main(int argc, char** argv) {
+    int epochs = DEFAULT_EPOCHS;
+    double rate = DEFAULT_RATE;
+    double k = 0;
+    int threadCount = std::max((int)std::thread::hardware_concurrency(), 1);
+    std::string output = "PieceValue.h";
+    std::string input;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-epochs" && i + 1 < argc) {
+            epochs = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "-rate" && i + 1 < argc) {
+            rate = std::atof(argv[++i]);
+        } else if (arg == "-k" && i + 1 < argc) {
+            k = std::atof(argv[++i]);
+        } else if (arg == "-threads" && i + 1 < argc) {
+            threadCount = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg[0] != '-' && input.empty()) {
+            input = arg;
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty()) {
+        std::cerr << "usage: tune [-epochs N] [-rate R] [-k K] [-threads N] [-o PieceValue.h] data.bin" << std::endl;
+        return 1;
+    }
+    PackedDataset dataset;
+    if (!dataset.open(input)) {
+        std::cerr << "Could not open " << input << " as a packed dataset" << std::endl;
+        return 1;
+    }
+
+    // score every position once; records without a result and known
+    // endgames, which the tables play no part in, are left out
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<TuningEntry>> loaded(threadCount);
+    Board engineBoard;
+    Engine engine(engineBoard, 'W');
+    engine.setHashSize(1);
+    parallelFor(dataset.size(), threadCount, [&](int t, size_t begin, size_t end) {
+        Board board;
+        for (size_t i = begin; i < end; i++) {
+            const PackedPosition& packed = dataset[i];
+            if (packed.result >= NO_RESULT || !board.loadPacked(packed) || probeEndgame(board)) {
+                continue;
+            }
+            TuningEntry entry;
+            entry.packed = &packed;
+            entry.phase = std::min(board.gamePhase, MAX_PHASE);
+            entry.remainder = engine.evaluate(board) - taper(board.psqScore, board.gamePhase);
+            entry.result = packed.result * 0.5f;
+            loaded[t].push_back(entry);
+        }
+    });
+    std::vector<TuningEntry> entries;
+    for (auto& part : loaded) {
+        entries.insert(entries.end(), part.begin(), part.end());
+        std::vector<TuningEntry>().swap(part);
+    }
+    if (entries.empty()) {
+        std::cerr << "No positions with a game result in " << input << std::endl;
+        return 1;
+    }
+    std::vector<double> params;
+    initialParameters(params);
+    std::cerr << "Loaded " << entries.size() << " of " << dataset.size() << " positions in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    if (k <= 0) {
+        k = fitScalingConstant(entries, params, threadCount);
+    }
+    std::cerr << "K " << k << ", error " << meanError(entries, params, k, threadCount) << std::endl;
+
+    std::vector<double> grad, moment(PARAM_COUNT, 0), velocity(PARAM_COUNT, 0);
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        auto epochStart = std::chrono::steady_clock::now();
+        double error = gradient(entries, params, k, threadCount, grad);
+        // the gradient is tiny in centipawn units, Adam normalises it per parameter
+        for (int p = 0; p < PARAM_COUNT; p++) {
+            moment[p] = ADAM_BETA1 * moment[p] + (1 - ADAM_BETA1) * grad[p];
+            velocity[p] = ADAM_BETA2 * velocity[p] + (1 - ADAM_BETA2) * grad[p] * grad[p];
+            double m = moment[p] / (1 - std::pow(ADAM_BETA1, epoch));
+            double v = velocity[p] / (1 - std::pow(ADAM_BETA2, epoch));
+            params[p] -= rate * m / (std::sqrt(v) + ADAM_EPSILON);
+        }
+        if (epoch % REPORT_INTERVAL == 0 || epoch == epochs) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - epochStart).count();
+            std::cerr << "epoch " << epoch << ", error " << error << ", " << seconds << " s/epoch" << std::endl;
+            if (!writeHeader(output, params)) {
+                std::cerr << "Could not write " << output << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (epochs == 0 && !writeHeader(output, params)) {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
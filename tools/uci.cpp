@@ -0,0 +1,340 @@
+// UCI front end for tournament managers and headless use, no SFML needed.
+// Commands are read on the main thread while the search runs on its own
+// thread, so isready, stop and ponderhit are answered mid-search.
+// "bench [depth] [json]", as a command or as the program's arguments,
+// searches a fixed set of positions and reports nodes and speed. Setting
+// the TraceFile option records every search into that file, see Trace.h.
+#include "Bench.h"
+#include "Board.h"
+#include "Engine.h"
+#include "Bitbase.h"
+#include "San.h"
+#include "Trace.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+// megabytes, matches EVAL_CACHE_SIZE
+#define DEFAULT_HASH 8
+#define MAX_HASH 4096
+#define MAX_THREADS 256
+
+typedef std::pair<std::pair<int, int>, std::pair<int, int>> Move;
+
+static std::mutex outputMutex;
+
+// the GUI reads lines, whole lines from different threads must not interleave
+static void send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+static std::string moveName(const Board& board, const Move& move) {
+    auto [from, to] = move;
+    if (from.first < 0) {
+        return "0000";
+    }
+    return coordinateMove(board, from.first, from.second, to.first, to.second);
+}
+
+// score from the side to move's point of view as "cp N" or "mate N", N in
+// moves and negative when the side to move is the one getting mated
+static std::string uciScore(int score) {
+    if (std::abs(score) < MATE_BOUND) {
+        return "cp " + std::to_string(score);
+    }
+    int plies = MATE_SCORE - std::abs(score);
+    return "mate " + std::to_string(score > 0 ? (plies + 1) / 2 : -(plies / 2));
+}
+
+class UciSession {
+private:
+    Board board;
+    Engine engine{board, 'W'};
+    std::thread searchThread;
+    // guards the flags below, which decide when bestmove may be sent
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    bool stopReceived = false;
+    bool infiniteSearch = false;
+    bool ponderSearch = false;
+    // written after each search while tracing, empty when not
+    std::string traceFile;
+
+    void waitForSearch() {
+        if (searchThread.joinable()) {
+            stop();
+            searchThread.join();
+        }
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopReceived = true;
+        engine.stop();
+        stateChanged.notify_all();
+    }
+
+    void ponderHit() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ponderSearch = false;
+        engine.ponderHit();
+        stateChanged.notify_all();
+    }
+
+    void setPosition(std::istringstream& in) {
+        std::string token, fen;
+        in >> token;
+        if (token == "startpos") {
+            fen = START_FEN;
+            in >> token;
+        } else if (token == "fen") {
+            while (in >> token && token != "moves") {
+                fen += (fen.empty() ? "" : " ") + token;
+            }
+        } else {
+            return;
+        }
+        if (!board.loadFromFEN(fen)) {
+            send("info string invalid fen " + fen);
+            return;
+        }
+        if (token != "moves") {
+            return;
+        }
+        while (in >> token) {
+            SanMove move;
+            if (!parseCoordinateMove(token, move) ||
+                !board.movePiece(move.fromX, move.fromY, move.toX, move.toY, board.getSideToMove(), move.promotion)) {
+                send("info string illegal move " + token);
+                return;
+            }
+        }
+    }
+
+    void go(std::istringstream& in) {
+        SearchLimits limits;
+        std::string token;
+        while (in >> token) {
+            if (token == "wtime") in >> limits.time[0];
+            else if (token == "btime") in >> limits.time[1];
+            else if (token == "winc") in >> limits.increment[0];
+            else if (token == "binc") in >> limits.increment[1];
+            else if (token == "movestogo") in >> limits.movesToGo;
+            else if (token == "depth") in >> limits.depth;
+            else if (token == "nodes") in >> limits.nodes;
+            else if (token == "movetime") in >> limits.moveTime;
+            else if (token == "infinite") limits.infinite = true;
+            else if (token == "ponder") limits.ponder = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopReceived = false;
+            infiniteSearch = limits.infinite;
+            ponderSearch = limits.ponder;
+        }
+        searchThread = std::thread([this, limits]() {
+            if (Trace::isEnabled()) {
+                Trace::setThreadName("uci search");
+            }
+            char side = board.getSideToMove();
+            bool ponderHitSent = false;
+            SearchInfo result = engine.search(side, limits, [&](const SearchInfo& info) {
+                // search() clears the stop and ponder state when it starts, a
+                // stop or ponderhit that came before that is passed on again
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    if (stopReceived) {
+                        engine.stop();
+                    }
+                    if (limits.ponder && !ponderSearch && !ponderHitSent) {
+                        engine.ponderHit();
+                        ponderHitSent = true;
+                    }
+                }
+                int score = (side == 'W') ? info.score : -info.score;
+                uint64_t nps = info.time > 0 ? info.nodes * 1000 / info.time : info.nodes;
+                send("info depth " + std::to_string(info.depth) + " score " + uciScore(score) +
+                     " nodes " + std::to_string(info.nodes) + " nps " + std::to_string(nps) +
+                     " time " + std::to_string(info.time) + " pv " + moveName(board, info.bestMove));
+            });
+            // in infinite and ponder mode bestmove waits for stop or ponderhit
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                stateChanged.wait(lock, [this] { return stopReceived || (!infiniteSearch && !ponderSearch); });
+            }
+            // builds with SEARCH_STATS report the search's counters before the move
+            if (engine.getSearchStats().enabled) {
+                std::ostringstream stats;
+                engine.getSearchStats().print(stats);
+                std::istringstream lines(stats.str());
+                std::string statsLine;
+                while (std::getline(lines, statsLine)) {
+                    send("info string " + statsLine);
+                }
+            }
+            std::string line = "bestmove " + moveName(board, result.bestMove);
+            if (result.ponderMove.first.first >= 0) {
+                Board next = board;
+                next.movePiece(result.bestMove.first.first, result.bestMove.first.second,
+                               result.bestMove.second.first, result.bestMove.second.second, side);
+                line += " ponder " + moveName(next, result.ponderMove);
+            }
+            send(line);
+            if (!traceFile.empty() && !Trace::write(traceFile)) {
+                send("info string could not write " + traceFile);
+            }
+        });
+    }
+
+    void setOption(std::istringstream& in) {
+        std::string token, name, value;
+        in >> token;
+        while (in >> token && token != "value") {
+            name += (name.empty() ? "" : " ") + token;
+        }
+        std::getline(in >> std::ws, value);
+        if (name == "Threads") {
+            engine.setThreads(std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS));
+        } else if (name == "Hash") {
+            engine.setHashSize(std::clamp(std::atoi(value.c_str()), 1, MAX_HASH));
+        } else if (name == "TraceFile") {
+            traceFile = (value == "<empty>") ? "" : value;
+            if (traceFile.empty()) {
+                Trace::stop();
+            } else {
+                Trace::start();
+            }
+        } else if (name != "Ponder") {
+            send("info string unknown option " + name);
+        }
+    }
+
+    // progress goes to stderr, the report to the GUI
+    void bench(std::istringstream& in) {
+        std::vector<std::string> arguments;
+        std::string token;
+        while (in >> token) {
+            arguments.push_back(token);
+        }
+        int depth;
+        bool json;
+        if (!parseBenchArguments(arguments, depth, json)) {
+            send("info string usage: bench [depth] [json]");
+            return;
+        }
+        std::ostringstream report;
+        printBench(runBench(depth, &std::cerr), report, json);
+        std::string line;
+        std::istringstream lines(report.str());
+        while (std::getline(lines, line)) {
+            send(line);
+        }
+    }
+
+public:
+    UciSession() {
+        board.loadFromFEN(START_FEN);
+        engine.setUseNnue(Nnue::isLoaded());
+    }
+
+    void setBook(const PolyglotBook* book) {
+        engine.setBook(book);
+    }
+
+    // false once the GUI asked to quit
+    bool handle(const std::string& line) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+        if (command == "uci") {
+            send("id name BadFish");
+            send("id author BadFish developers");
+            send("option name Hash type spin default " + std::to_string(DEFAULT_HASH) +
+                 " min 1 max " + std::to_string(MAX_HASH));
+            send("option name Threads type spin default " + std::to_string(std::max((int)std::thread::hardware_concurrency(), 1)) +
+                 " min 1 max " + std::to_string(MAX_THREADS));
+            send("option name Ponder type check default false");
+            send("option name TraceFile type string default <empty>");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "setoption") {
+            waitForSearch();
+            setOption(in);
+        } else if (command == "ucinewgame") {
+            waitForSearch();
+            engine.clearHash();
+        } else if (command == "position") {
+            waitForSearch();
+            setPosition(in);
+        } else if (command == "go") {
+            waitForSearch();
+            go(in);
+        } else if (command == "stop") {
+            stop();
+        } else if (command == "ponderhit") {
+            ponderHit();
+        } else if (command == "bench") {
+            waitForSearch();
+            bench(in);
+        } else if (command == "quit") {
+            waitForSearch();
+            return false;
+        }
+        return true;
+    }
+
+    ~UciSession() {
+        waitForSearch();
+    }
+};
+
+int main(int argc, char** argv) {
+    // stdout belongs to the protocol, problems go to stderr
+#ifdef BITBASE_DIR
+    if (loadBitbases(BITBASE_DIR) == 0) {
+        std::cerr << "No endgame bitbases found in " << BITBASE_DIR << std::endl;
+    }
+#endif
+#ifdef NNUE_FILE
+    if (!Nnue::load(NNUE_FILE)) {
+        std::cerr << "Could not load " << NNUE_FILE << ", using the classic evaluator" << std::endl;
+    }
+#endif
+#ifdef BOOK_RANDOM_FILE
+    if (!loadPolyglotRandom(BOOK_RANDOM_FILE)) {
+        std::cerr << "Could not read Polyglot random numbers from " << BOOK_RANDOM_FILE << std::endl;
+    }
+#endif
+    // declared first, the session's search may still use it while shutting down
+    PolyglotBook book;
+    UciSession session;
+#ifdef BOOK_FILE
+    if (book.open(BOOK_FILE)) {
+        session.setBook(&book);
+    } else {
+        std::cerr << "Could not open " << BOOK_FILE
+                  << (polyglotRandomLoaded() ? "" : ", it needs the Polyglot random numbers from BOOK_RANDOM_FILE") << std::endl;
+    }
+#endif
+    std::string line;
+    if (argc > 1) {
+        // a single command, e.g. "badfish-uci bench"
+        for (int i = 1; i < argc; i++) {
+            line += (i > 1 ? " " : "") + std::string(argv[i]);
+        }
+        session.handle(line);
+        return 0;
+    }
+    while (std::getline(std::cin, line) && session.handle(line)) {
+    }
+    return 0;
+}